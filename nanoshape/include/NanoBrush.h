@@ -27,6 +27,7 @@
 #pragma once
 
 #include <QColor>
+#include <QGradient>
 #include <QImage>
 #include <QRectF>
 
@@ -36,6 +37,16 @@ struct NVGpaint;
 
 class NanoBrush
 {
+public:
+    // gradient with color stops is baked into ramp image, this is how the ramp is sampled
+    enum class Ramp
+    {
+        None,
+        Box, // linear, box and radial gradient, which are all box gradient in NanoVG
+        Conical,
+        Focal,
+    };
+
 public:
     NanoBrush();
     NanoBrush(Qt::GlobalColor color);
@@ -46,6 +57,7 @@ public:
 
     const QImage& image() const { return m_image; }
     const NVGpaint& paint() const { return *m_paint; }
+    Ramp ramp() const { return m_ramp; }
 
     /// Creates a linear gradient.
     static NanoBrush linearGradient(const QColor& startColor, const QColor& endColor,
@@ -61,6 +73,23 @@ public:
     static NanoBrush radialGradient(const QColor& innerColor, const QColor& outerColor,
             const QPointF& center, qreal innerRadius, qreal outerRadius);
 
+    /// Creates a linear gradient with color stops.
+    static NanoBrush linearGradient(const QGradientStops& stops, const QPointF& start, const QPointF& end);
+
+    /// Creates a box gradient with color stops, the stops go from the inner box to the outer feather.
+    static NanoBrush boxGradient(const QGradientStops& stops, const QRectF& box, qreal cornerRadius, qreal feather);
+
+    /// Creates a radial gradient with color stops, the stops go from innerRadius to outerRadius.
+    static NanoBrush radialGradient(const QGradientStops& stops, const QPointF& center, qreal innerRadius, qreal outerRadius);
+
+    /// Creates a radial gradient with color stops, the stops go from the focal point to the circle,
+    /// the same as QRadialGradient. The focal point is kept inside the circle.
+    static NanoBrush focalGradient(const QGradientStops& stops, const QPointF& center, qreal radius, const QPointF& focalPoint);
+
+    /// Creates a conical gradient with color stops, the same as QConicalGradient.
+    /// Parameter angle (in degree) is the start angle, and the stops go counter-clockwise.
+    static NanoBrush conicalGradient(const QGradientStops& stops, const QPointF& center, qreal angle);
+
     /// Creates and returns an image pattern.
     /// Parameters sourceRect specify the region of the image pattern,
     /// rotation (in degree) around the top-left corner.
@@ -75,8 +104,10 @@ public:
 
 private:
     explicit NanoBrush(const NVGpaint& paint);
+    NanoBrush(const NVGpaint& paint, Ramp ramp, const QGradientStops& stops);
 
 private:
     NVGpaint* m_paint;
     QImage m_image;
+    Ramp m_ramp = Ramp::None;
 };
@@ -28,6 +28,8 @@
 
 #include "NanoBrush.h"
 
+#include <QStringList>
+
 class QQuickItem;
 class QSGNode;
 class QSGGeometryNode;
@@ -40,6 +42,13 @@ class NanoPainterPrivate;
 class NanoPainter
 {
 public:
+    struct Statistics
+    {
+        int drawCalls = 0;
+        int triangles = 0;
+        int culledCalls = 0;
+    };
+
     enum class Composite
     {
         SourceOver,
@@ -61,8 +70,37 @@ public:
     NanoPainter(NanoPainter&&) = delete;
     ~NanoPainter();
 
+    // the pixel ratio used by tessellation, it is updated on reset
     float itemPixelRatio() const;
 
+    // use the fixed pixel ratio on next reset, or 0 to follow the item (including scale of its parents)
+    void setItemPixelRatio(float ratio);
+
+    // draw all the paint calls with a single render node, instead of one geometry node per call.
+    // it requires Qt 6.6 or later, otherwise it is ignored.
+    bool isRenderNodeEnabled() const;
+    void setRenderNodeEnabled(bool enabled);
+
+    // tessellate the fill and stroke calls on the global thread pool, the result is the same as serial tessellation.
+    // each call takes a copy of the path and state, so it only pays off for many calls or complex paths.
+    bool isParallelTessellationEnabled() const;
+    void setParallelTessellationEnabled(bool enabled);
+
+    // fill and stroke outside of the visible rect (in item coordinates) are dropped before tessellation.
+    // it is null by default, which means no culling.
+    QRectF visibleRect() const;
+    void setVisibleRect(const QRectF& rect);
+
+    // the statistics of the last updatePaintNode
+    Statistics statistics() const;
+
+    // keep the tessellated triangles of the named paths (see beginPath) for pathAt and pathsIn.
+    // it is off by default, the query is against the last updatePaintNode in item coordinates.
+    bool isHitTestEnabled() const;
+    void setHitTestEnabled(bool enabled);
+    QString pathAt(const QPointF& point) const;
+    QStringList pathsIn(const QRectF& rect) const;
+
     void reset();
     void reset(QSGNode* oldNode);
 
@@ -84,6 +122,14 @@ public:
     void postSKewY(qreal degree);
     void postShear(qreal sh, qreal sv);
 
+    // the clip rect is in the current transform, and evaluated in the shader with 1px antialiased edge.
+    // the paint calls completely outside of it are dropped before tessellation.
+    void setClipRect(float x, float y, float width, float height);
+    void setClipRect(const QRectF& rect);
+    void intersectClipRect(float x, float y, float width, float height);
+    void intersectClipRect(const QRectF& rect);
+    void resetClipRect();
+
     Composite compositeOperation() const;
     void setCompositeOperation(Composite op);
 
@@ -96,6 +142,11 @@ public:
     Qt::PenJoinStyle joinStyle() const;
     void setJoinStyle(Qt::PenJoinStyle style);
 
+    // the points of the path closer than tolerance (in device pixels) to the simplified polyline are dropped,
+    // it is useful for dense data like sensor traces. default is 0, no simplification.
+    qreal simplifyTolerance() const;
+    void setSimplifyTolerance(qreal tolerance);
+
     // the dash offset will be scaled with stroke width
     // just like QPen::dashOffset
     qreal dashOffset() const;
@@ -106,6 +157,7 @@ public:
     QVector<qreal> dashPattern() const;
     void setDashPattern(const QVector<qreal>& pattern);
 
+    // the stroke not wider than 1 device pixel is drawn as hairline, the joins are skipped
     qreal strokeWidth() const;
     void setStrokeWidth(qreal width);
 
@@ -147,6 +199,11 @@ public:
     void addCircle(const QPointF& centerPoint, qreal radius);
 
     void addPolygon(const QPolygonF& polygon);
+
+    // points are packed as [x0, y0, x1, y1, ...], count is the number of points
+    void addPolygon(const float* points, int count, bool closed = false);
+    void addPolygon(const double* points, int count, bool closed = false);
+
     void addPath(const QPainterPath& path);
 
     void asInverted();
@@ -157,6 +214,11 @@ public:
     QSGNode* updatePaintNode(QSGNode* node = nullptr);
 
     static float itemPixelRatio(QQuickItem* item);
+
+    // the nearest level of detail (power of sqrt(2)) of the pixel ratio,
+    // so the geometry can be reused for small change of scale
+    static float itemPixelRatioBucket(float ratio);
+    static QRectF itemVisibleRect(QQuickItem* item);
     static bool updatePaintNodeStrokeBrush(QQuickItem* item, QSGNode* node, const QString& name, const NanoBrush& brush);
     static bool updatePaintNodeFillBrush(QQuickItem* item, QSGNode* node, const QString& name, const NanoBrush& brush);
 
@@ -28,6 +28,11 @@
 
 #include <QMatrix4x4>
 #include <QQuickItem>
+#include <QSet>
+#include <QTimer>
+
+#include <memory>
+#include <vector>
 
 #include "NanoPainter.h"
 
@@ -37,6 +42,47 @@ class NanoShapePainter : public QObject, public NanoPainter
 {
     Q_OBJECT
 
+public:
+    // command code used by execute(), the arguments follow the command code
+    enum Command
+    {
+        CommandBeginPath, // ()
+        CommandMoveTo, // (x, y)
+        CommandLineTo, // (x, y)
+        CommandBezierTo, // (c1x, c1y, c2x, c2y, x, y)
+        CommandQuadTo, // (cx, cy, x, y)
+        CommandArcTo, // (c1x, c1y, c2x, c2y, radius)
+        CommandCloseSubpath, // ()
+        CommandAddArc, // (cx, cy, radius, angle0, angle1, clockwise)
+        CommandAddRect, // (x, y, width, height)
+        CommandAddRoundedRect, // (x, y, width, height, radius)
+        CommandAddEllipse, // (centerX, centerY, radiusX, radiusY)
+        CommandAddCircle, // (centerX, centerY, radius)
+        CommandAddPolygon, // (count, x0, y0, x1, y1, ...), count is the number of points
+        CommandAsInverted, // ()
+        CommandStroke, // ()
+        CommandFill, // ()
+        CommandSetStrokeWidth, // (width)
+        CommandSetMiterLimit, // (limit)
+        CommandSetCapStyle, // (Qt.PenCapStyle)
+        CommandSetJoinStyle, // (Qt.PenJoinStyle)
+        CommandSetCompositeStyle, // (NanoShape.CompositeStyle)
+        CommandSetDashOffset, // (offset)
+        CommandSetDashPattern, // (count, d0, d1, ...)
+        CommandSetStrokeColor, // (r, g, b, a), in range [0, 1]
+        CommandSetFillColor, // (r, g, b, a), in range [0, 1]
+        CommandResetTransform, // ()
+        CommandSetTransform, // (m11, m12, m21, m22, dx, dy)
+        CommandPreTranslate, // (x, y)
+        CommandPreScale, // (sx, sy)
+        CommandPreRotate, // (degree)
+        CommandSetClipRect, // (x, y, width, height)
+        CommandIntersectClipRect, // (x, y, width, height)
+        CommandResetClipRect, // ()
+        CommandSetSimplifyTolerance, // (tolerance)
+    };
+    Q_ENUM(Command)
+
 public:
     explicit NanoShapePainter(QQuickItem* item);
     virtual ~NanoShapePainter();
@@ -59,6 +105,11 @@ public:
     Q_INVOKABLE void postSKewY(qreal degree);
     Q_INVOKABLE void postShear(qreal sh, qreal sv);
 
+    // the clip rect is in the current transform
+    Q_INVOKABLE void setClipRect(float x, float y, float width, float height);
+    Q_INVOKABLE void intersectClipRect(float x, float y, float width, float height);
+    Q_INVOKABLE void resetClipRect();
+
     // see NanoShape.CompositeStyle
     Q_INVOKABLE void setCompositeStyle(int op);
 
@@ -67,6 +118,9 @@ public:
     Q_INVOKABLE void setMiterLimit(qreal limit);
     Q_INVOKABLE void setStrokeWidth(qreal width);
 
+    // in device pixels, see NanoPainter::setSimplifyTolerance
+    Q_INVOKABLE void setSimplifyTolerance(qreal tolerance);
+
     // the dash offset and pattern will be scaled with stroke width
     Q_INVOKABLE void setDashOffset(qreal offset);
     Q_INVOKABLE void setDashPattern(const QVector<qreal>& pattern);
@@ -92,7 +146,9 @@ public:
     Q_INVOKABLE void addCircle(float centerX, float centerY, float radius);
 
     // accept the following type:
-    // QPolygonF, QVector<QPointF>, qml array of Qt.point, qml array of number (in [x0, y0, x1, y1, ...] format)
+    // QPolygonF, QVector<QPointF>, qml array of Qt.point, qml array of number (in [x0, y0, x1, y1, ...] format),
+    // Float32Array or Float64Array (in [x0, y0, x1, y1, ...] format), ArrayBuffer (as Float32Array).
+    // typed array is read directly without converting each number, it is the fastest way for large polygon.
     Q_INVOKABLE void addPolygon(const QVariant& polygon);
 
     // make previous subpath as inverted (aka. hole)
@@ -102,6 +158,11 @@ public:
     Q_INVOKABLE void stroke();
     Q_INVOKABLE void fill();
 
+    // execute packed commands in one call, see NanoShapePainter.Command for the format.
+    // accept Float32Array, Float64Array or ArrayBuffer (as Float32Array).
+    // return false if the commands are malformed, the commands before the malformed one are still executed.
+    Q_INVOKABLE bool execute(const QVariant& commands);
+
     Q_INVOKABLE static QVariant linearGradient(const QColor& startColor, const QColor& endColor,
             qreal sx, qreal sy, qreal ex, qreal ey);
 
@@ -111,8 +172,48 @@ public:
     Q_INVOKABLE static QVariant radialGradient(const QColor& innerColor, const QColor& outerColor,
             qreal cx, qreal cy, qreal innerRadius, qreal outerRadius);
 
-    Q_INVOKABLE static QVariant imagePattern(const QUrl& imageUrl,
+    // gradients with color stops, stops is an array of [position, color] pairs,
+    // or objects with position and color properties (like GradientStop)
+    Q_INVOKABLE static QVariant linearGradient(const QVariant& stops,
+            qreal sx, qreal sy, qreal ex, qreal ey);
+
+    Q_INVOKABLE static QVariant boxGradient(const QVariant& stops,
+            qreal bx, qreal by, qreal bw, qreal bh, qreal cornerRadius, qreal feather);
+
+    Q_INVOKABLE static QVariant radialGradient(const QVariant& stops,
+            qreal cx, qreal cy, qreal innerRadius, qreal outerRadius);
+
+    Q_INVOKABLE static QVariant focalGradient(const QVariant& stops,
+            qreal cx, qreal cy, qreal radius, qreal fx, qreal fy);
+
+    Q_INVOKABLE static QVariant conicalGradient(const QVariant& stops,
+            qreal cx, qreal cy, qreal angle);
+
+    // the image is decoded asynchronously and cached, a transparent brush is returned until it is ready,
+    // then pendingImageReady() is emitted. the relative url is resolved against the qml context of the item,
+    // and image:// url of the QML engine image providers are supported.
+    Q_INVOKABLE QVariant imagePattern(const QString& imageUrl,
             const QRectF& part = {}, qreal rotation = 0, qreal opacity = 1);
+
+    // same as above, but without the QML engine, the caller has to repaint once the image is ready
+    static QVariant imagePattern(const QUrl& imageUrl,
+            const QRectF& part = {}, qreal rotation = 0, qreal opacity = 1);
+
+    // forget the images that are still pending
+    void clearPendingImages();
+
+    // memory budget (in bytes) of the process-wide image cache used by imagePattern(), default is 64MB
+    static int imageCacheLimit();
+    static void setImageCacheLimit(int bytes);
+
+signals:
+    void pendingImageReady();
+
+private:
+    void onImageReady(const QString& key);
+
+private:
+    QSet<QString> m_pendingImages;
 };
 
 QML_DECLARE_TYPE(NanoShapePainter)
@@ -122,6 +223,11 @@ QML_DECLARE_TYPE(NanoShapePainter)
 class NanoShape : public QQuickItem
 {
     Q_OBJECT
+    Q_PROPERTY(QStringList layers READ layers WRITE setLayers NOTIFY layersChanged)
+    Q_PROPERTY(bool renderNodeEnabled READ isRenderNodeEnabled WRITE setRenderNodeEnabled NOTIFY renderNodeEnabledChanged)
+    Q_PROPERTY(bool parallelTessellationEnabled READ isParallelTessellationEnabled WRITE setParallelTessellationEnabled NOTIFY parallelTessellationEnabledChanged)
+    Q_PROPERTY(bool culling READ isCulling WRITE setCulling NOTIFY cullingChanged)
+    Q_PROPERTY(bool hitTestEnabled READ isHitTestEnabled WRITE setHitTestEnabled NOTIFY hitTestEnabledChanged)
 
 public:
     enum CompositeStyle
@@ -144,10 +250,48 @@ public:
     explicit NanoShape(QQuickItem* parent = nullptr);
     virtual ~NanoShape();
 
+    // named layers are painted in order on top of the default layer (painted by paint signal),
+    // each layer is painted by paintLayer signal, and only repainted when it is marked dirty.
+    QStringList layers() const;
+    void setLayers(const QStringList& layers);
+
+    // draw each layer with a single render node, see NanoPainter::setRenderNodeEnabled
+    bool isRenderNodeEnabled() const;
+    void setRenderNodeEnabled(bool enabled);
+
+    // tessellate the paint calls on the thread pool, see NanoPainter::setParallelTessellationEnabled
+    bool isParallelTessellationEnabled() const;
+    void setParallelTessellationEnabled(bool enabled);
+
+    // drop the paint calls outside of the visible part of the item (clipped by window and ancestors),
+    // the layer is painted again once it is scrolled out of the painted area.
+    bool isCulling() const;
+    void setCulling(bool enabled);
+
+    // keep the painted triangles of the named paths for pathAt and pathsIn, see NanoPainter::setHitTestEnabled
+    bool isHitTestEnabled() const;
+    void setHitTestEnabled(bool enabled);
+
+    // the topmost named path under the point, or empty string if none
+    Q_INVOKABLE QString pathAt(qreal x, qreal y) const;
+
+    // all the named paths that intersect the rect, from bottom to top
+    Q_INVOKABLE QStringList pathsIn(qreal x, qreal y, qreal width, qreal height) const;
+
+    // mark all layers dirty
     Q_INVOKABLE void markDirty();
 
+    // mark the named layer dirty, empty name for the default layer
+    Q_INVOKABLE void markLayerDirty(const QString& layer);
+
 signals:
     void paint(NanoShapePainter* painter);
+    void paintLayer(const QString& layer, NanoShapePainter* painter);
+    void layersChanged();
+    void renderNodeEnabledChanged();
+    void parallelTessellationEnabledChanged();
+    void cullingChanged();
+    void hitTestEnabledChanged();
 
 protected:
     virtual void itemChange(ItemChange change, const ItemChangeData& data) override;
@@ -161,11 +305,44 @@ protected:
 
 private:
     void prepare();
+    void trackPixelRatio();
+    void updatePixelRatio();
+    void setPixelRatio(float ratio);
+    float currentPixelRatio() const;
+
+private:
+    struct Layer
+    {
+        QString name;
+        std::unique_ptr<NanoShapePainter> painter;
+        bool dirty = true;
+        bool recorded = false;
+        QRectF cullRect;
+    };
+
+    void addLayer(const QString& name);
 
 private:
-    NanoShapePainter m_painter;
+    // the first one is the default layer
+    std::vector<Layer> m_layers;
+
+    // the pixel ratio of tessellation, it is the nearest bucket while the scale is changing,
+    // and the exact ratio once the scale is settled
+    std::vector<QMetaObject::Connection> m_pixelRatioConnections;
+    QTimer m_pixelRatioTimer;
+
+    // the scale of each parent (nearest first) and their product, they are updated by the parent that is changed,
+    // so the parent chain is only walked when it is changed
+    std::vector<qreal> m_parentScales;
+    qreal m_parentScale = 1;
+
     float m_itemPixelRatio = 1;
-    bool m_dirty = true;
+    bool m_pixelRatioDirty = true;
+    bool m_layersChanged = false;
+    bool m_renderNodeEnabled = false;
+    bool m_parallelTessellationEnabled = false;
+    bool m_culling = false;
+    bool m_hitTestEnabled = false;
 };
 
 QML_DECLARE_TYPE(NanoShape)
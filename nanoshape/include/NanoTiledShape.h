@@ -0,0 +1,110 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+
+#include "NanoShape.h"
+
+#include <unordered_map>
+
+class NanoTileNode;
+
+//---------------------------------------------------------------------------
+
+// for very large content, the item is split into tiles, and only the visible tiles are painted.
+// each tile is painted by paintTile signal with the tile rect, and the paint calls outside of
+// the tile are dropped. the tiles are bigger when zoomed out (by scale of the item or its parents),
+// so about the same number of tiles are visible, and the hidden tiles are kept until the cache limit is reached.
+class NanoTiledShape : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(qreal tileSize READ tileSize WRITE setTileSize NOTIFY tileSizeChanged)
+    Q_PROPERTY(int cacheLimit READ cacheLimit WRITE setCacheLimit NOTIFY cacheLimitChanged)
+
+public:
+    explicit NanoTiledShape(QQuickItem* parent = nullptr);
+    virtual ~NanoTiledShape();
+
+    // the size of tile in pixels, default is 512
+    qreal tileSize() const;
+    void setTileSize(qreal size);
+
+    // memory budget (in bytes) of the vertex data of the hidden tiles, default is 32MB
+    int cacheLimit() const;
+    void setCacheLimit(int bytes);
+
+    // mark all tiles dirty
+    Q_INVOKABLE void markDirty();
+
+    // mark the tiles that intersect the rect dirty
+    Q_INVOKABLE void markRectDirty(qreal x, qreal y, qreal width, qreal height);
+
+signals:
+    void paintTile(NanoShapePainter* painter, const QRectF& tile);
+    void tileSizeChanged();
+    void cacheLimitChanged();
+
+protected:
+    virtual void itemChange(ItemChange change, const ItemChangeData& data) override;
+    virtual QSGNode* updatePaintNode(QSGNode* node, UpdatePaintNodeData*) override;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    virtual void geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) override;
+#else
+    virtual void geometryChanged(const QRectF& newGeometry, const QRectF& oldGeometry) override;
+#endif
+
+private:
+    void prepare();
+    QRectF tileRect(qint64 key) const;
+
+private:
+    struct Tile
+    {
+        bool dirty = false;
+        bool painted = false;
+        quint64 lastVisible = 0;
+        NanoTileNode* node = nullptr;
+    };
+
+    struct PendingTile
+    {
+        qint64 key;
+        NanoShapePainter* painter;
+    };
+
+    // tile key is (level << 48 | row << 24 | column), the tile size of level n is tileSize / 2^n
+    std::unordered_map<qint64, Tile> m_tiles;
+    std::vector<qint64> m_visibleTiles;
+    std::vector<PendingTile> m_pendingTiles;
+    std::vector<std::unique_ptr<NanoShapePainter>> m_painters;
+    std::vector<NanoShapePainter*> m_freePainters;
+    quint64 m_frame = 0;
+    qreal m_tileSize = 512;
+    int m_cacheLimit = 32 * 1024 * 1024;
+};
+
+QML_DECLARE_TYPE(NanoTiledShape)
@@ -17,19 +17,32 @@ HEADERS += \
     include/NanoBrush.h \
     include/NanoPainter.h \
     include/NanoShape.h \
+    include/NanoTiledShape.h \
     nanovg/nanovg.h \
-    src/NanoMaterial.h
+    src/NanoHitIndex.h \
+    src/NanoImageCache.h \
+    src/NanoMaterial.h \
+    src/NanoRenderNode.h \
+    src/NanoResourceManager.h
 
 SOURCES += \
     nanovg/nanovg.c \
     src/NanoBrush.cpp \
+    src/NanoHitIndex.cpp \
+    src/NanoImageCache.cpp \
     src/NanoMaterial.cpp \
     src/NanoPainter.cpp \
-    src/NanoShape.cpp
+    src/NanoRenderNode.cpp \
+    src/NanoResourceManager.cpp \
+    src/NanoShape.cpp \
+    src/NanoTiledShape.cpp
 
 DISTFILES += \
     shaders/NanoShaderGLES.vert \
-    shaders/NanoShaderGLES.frag
+    shaders/NanoShaderGLESColor.frag \
+    shaders/NanoShaderGLESColorAA.frag \
+    shaders/NanoShaderGLESGradient.frag \
+    shaders/NanoShaderGLESImagePattern.frag
 
 RESOURCES += \
     shaders/NanoShadersGLES.qrc
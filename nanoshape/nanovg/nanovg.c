@@ -33,6 +33,14 @@
 #include "stb_image.h"
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NVG_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define NVG_NEON 1
+#endif
+
 #ifdef _MSC_VER
 #pragma warning(disable: 4100)  // unreferenced formal parameter
 #pragma warning(disable: 4127)  // conditional expression is constant
@@ -69,6 +77,7 @@ enum NVGpointFlags
     NVG_PT_LEFT = 0x02,
     NVG_PT_BEVEL = 0x04,
     NVG_PR_INNERBEVEL = 0x08,
+    NVG_PT_KEEP = 0x10,
 };
 
 struct NVGstate {
@@ -97,6 +106,20 @@ struct NVGstate {
 };
 typedef struct NVGstate NVGstate;
 
+struct NVGsnapshot {
+    NVGstate state;
+    float* commands;
+    int ncommands;
+    float commandx, commandy;
+    float tessTol;
+    float distTol;
+    float fringeWidth;
+    float devicePxRatio;
+    float simplifyTol;
+    int cullEnabled;
+    float cullBounds[4];
+};
+
 struct NVGpoint {
     float x,y;
     float dx, dy;
@@ -118,6 +141,11 @@ struct NVGpathCache {
     int cverts;
     float bounds[4];
     int forDash;
+    int* stack;
+    int cstack;
+    float* caps;
+    int ncaps;
+    int ccaps;
 };
 typedef struct NVGpathCache NVGpathCache;
 
@@ -143,6 +171,10 @@ struct NVGcontext {
     int fillTriCount;
     int strokeTriCount;
     int textTriCount;
+    int culledCount;
+    float simplifyTol;
+    int cullEnabled;
+    float cullBounds[4];
 };
 
 static float nvg__sqrtf(float a) { return sqrtf(a); }
@@ -181,6 +213,8 @@ static void nvg__deletePathCache(NVGpathCache* c)
     if (c->points != NULL) free(c->points);
     if (c->paths != NULL) free(c->paths);
     if (c->verts != NULL) free(c->verts);
+    if (c->stack != NULL) free(c->stack);
+    if (c->caps != NULL) free(c->caps);
     free(c);
 }
 
@@ -368,6 +402,24 @@ int nvgInternalCommands(NVGcontext* ctx, float** buffer)
     return ctx->ncommands;
 }
 
+void nvgInternalCullBounds(NVGcontext* ctx, const float* bounds)
+{
+    ctx->cullEnabled = bounds != NULL;
+    if (bounds) memcpy(ctx->cullBounds, bounds, sizeof(ctx->cullBounds));
+}
+
+void nvgInternalSimplifyTolerance(NVGcontext* ctx, float tol)
+{
+    ctx->simplifyTol = nvg__maxf(tol, 0.0f);
+}
+
+void nvgInternalStats(NVGcontext* ctx, int* drawCallCount, int* triCount, int* culledCount)
+{
+    if (drawCallCount) *drawCallCount = ctx->drawCallCount;
+    if (triCount) *triCount = ctx->fillTriCount + ctx->strokeTriCount + ctx->textTriCount;
+    if (culledCount) *culledCount = ctx->culledCount;
+}
+
 void nvgDeleteInternal(NVGcontext* ctx)
 {
 #ifndef NVG_NO_FONT
@@ -414,6 +466,7 @@ void nvgBeginFrame(NVGcontext* ctx, float windowWidth, float windowHeight, float
     ctx->fillTriCount = 0;
     ctx->strokeTriCount = 0;
     ctx->textTriCount = 0;
+    ctx->culledCount = 0;
 }
 
 void nvgCancelFrame(NVGcontext* ctx)
@@ -1133,19 +1186,25 @@ static float nvg__distPtSeg(float x, float y, float px, float py, float qx, floa
     return dx*dx + dy*dy;
 }
 
-static void nvg__appendCommands(NVGcontext* ctx, float* vals, int nvals)
+static float* nvg__allocCommands(NVGcontext* ctx, int nvals)
 {
-    NVGstate* state = nvg__getState(ctx);
-    int i;
-
     if (ctx->ncommands+nvals > ctx->ccommands) {
         float* commands;
         int ccommands = ctx->ncommands+nvals + ctx->ccommands/2;
         commands = (float*)realloc(ctx->commands, sizeof(float)*ccommands);
-        if (commands == NULL) return;
+        if (commands == NULL) return NULL;
         ctx->commands = commands;
         ctx->ccommands = ccommands;
     }
+    return &ctx->commands[ctx->ncommands];
+}
+
+static void nvg__appendCommands(NVGcontext* ctx, float* vals, int nvals)
+{
+    NVGstate* state = nvg__getState(ctx);
+    int i;
+
+    if (nvg__allocCommands(ctx, nvals) == NULL) return;
 
     if ((int)vals[0] != NVG_CLOSE && (int)vals[0] != NVG_WINDING) {
         ctx->commandx = vals[nvals-2];
@@ -1461,6 +1520,65 @@ static void nvg__flattenDashStroke(NVGcontext* ctx, NVGpathCache* cache)
     }
 }
 
+// Douglas-Peucker simplification of the polyline in place, the first and last points are kept.
+static int nvg__simplifyPath(NVGpathCache* cache, NVGpoint* pts, int count, float tol)
+{
+    int i, n, top, a, b, far;
+    float d, dmax;
+
+    if (count < 3) return count;
+
+    // each pending range on the stack is disjoint, so it can not be more than count
+    if (cache->cstack < count * 2) {
+        int* stack = (int*)realloc(cache->stack, sizeof(int) * count * 2);
+        if (stack == NULL) return count;
+        cache->stack = stack;
+        cache->cstack = count * 2;
+    }
+
+    for (i = 0; i < count; i++)
+        pts[i].flags &= ~NVG_PT_KEEP;
+    pts[0].flags |= NVG_PT_KEEP;
+    pts[count-1].flags |= NVG_PT_KEEP;
+
+    top = 0;
+    cache->stack[top++] = 0;
+    cache->stack[top++] = count-1;
+
+    while (top > 0) {
+        b = cache->stack[--top];
+        a = cache->stack[--top];
+        if (b - a < 2) continue;
+
+        far = -1;
+        dmax = tol*tol;
+        for (i = a+1; i < b; i++) {
+            d = nvg__distPtSeg(pts[i].x, pts[i].y, pts[a].x, pts[a].y, pts[b].x, pts[b].y);
+            if (d > dmax) {
+                dmax = d;
+                far = i;
+            }
+        }
+
+        if (far >= 0) {
+            pts[far].flags |= NVG_PT_KEEP;
+            cache->stack[top++] = a;
+            cache->stack[top++] = far;
+            cache->stack[top++] = far;
+            cache->stack[top++] = b;
+        }
+    }
+
+    n = 0;
+    for (i = 0; i < count; i++) {
+        if (pts[i].flags & NVG_PT_KEEP) {
+            pts[i].flags &= ~NVG_PT_KEEP;
+            pts[n++] = pts[i];
+        }
+    }
+    return n;
+}
+
 static void nvg__flattenPaths(NVGcontext* ctx, int forDash)
 {
     NVGpathCache* cache = ctx->cache;
@@ -1546,6 +1664,12 @@ static void nvg__flattenPaths(NVGcontext* ctx, int forDash)
             path->closed = 1;
         }
 
+        // Drop the points that are closer than simplifyTol (in device pixels) to the simplified polyline.
+        if (ctx->simplifyTol > 0.0f && path->count > 2) {
+            path->count = nvg__simplifyPath(cache, pts, path->count, ctx->simplifyTol / ctx->devicePxRatio);
+            p0 = &pts[path->count-1];
+        }
+
         // Enforce winding.
         if (path->count > 2) {
             area = nvg__polyArea(pts, path->count);
@@ -1577,6 +1701,29 @@ static int nvg__curveDivs(float r, float arc, float tol)
     return nvg__maxi(2, (int)ceilf(arc / da));
 }
 
+// The (cos, sin) of ncap points on the half circle, it is kept until ncap changes.
+static const float* nvg__capTable(NVGpathCache* cache, int ncap)
+{
+    int i;
+
+    if (cache->ncaps != ncap) {
+        if (cache->ccaps < ncap) {
+            float* caps = (float*)realloc(cache->caps, sizeof(float) * ncap * 2);
+            if (caps == NULL) return NULL;
+            cache->caps = caps;
+            cache->ccaps = ncap;
+        }
+        for (i = 0; i < ncap; i++) {
+            float a = i/(float)(ncap-1)*NVG_PI;
+            cache->caps[i*2] = cosf(a);
+            cache->caps[i*2+1] = sinf(a);
+        }
+        cache->ncaps = ncap;
+    }
+
+    return cache->caps;
+}
+
 static void nvg__chooseBevel(int bevel, NVGpoint* p0, NVGpoint* p1, float w,
                             float* x0, float* y0, float* x1, float* y1)
 {
@@ -1602,49 +1749,62 @@ static NVGvertex* nvg__roundJoin(NVGvertex* dst, NVGpoint* p0, NVGpoint* p1,
     float dly0 = -p0->dx;
     float dlx1 = p1->dy;
     float dly1 = -p1->dx;
+    float da, ax, ay, cs, sn, t;
     NVG_NOTUSED(fringe);
 
+    // The arc is rotated from (ax, ay) by the step angle, so only one sin and cos is needed per join.
+
     if (p1->flags & NVG_PT_LEFT) {
-        float lx0,ly0,lx1,ly1,a0,a1;
+        float lx0,ly0,lx1,ly1;
         nvg__chooseBevel(p1->flags & NVG_PR_INNERBEVEL, p0, p1, lw, &lx0,&ly0, &lx1,&ly1);
-        a0 = atan2f(-dly0, -dlx0);
-        a1 = atan2f(-dly1, -dlx1);
-        if (a1 > a0) a1 -= NVG_PI*2;
+        // Clockwise angle from -dl0 to -dl1, in (-2*PI, 0].
+        da = atan2f(dlx0*dly1 - dly0*dlx1, dlx0*dlx1 + dly0*dly1);
+        if (da > 0.0f) da -= NVG_PI*2;
 
         nvg__vset(dst, lx0, ly0, lu,1); dst++;
         nvg__vset(dst, p1->x - dlx0*rw, p1->y - dly0*rw, ru,1); dst++;
 
-        n = nvg__clampi((int)ceilf(((a0 - a1) / NVG_PI) * ncap), 2, ncap);
+        n = nvg__clampi((int)ceilf((-da / NVG_PI) * ncap), 2, ncap);
+        cs = cosf(da / (n-1));
+        sn = sinf(da / (n-1));
+        ax = -dlx0;
+        ay = -dly0;
         for (i = 0; i < n; i++) {
-            float u = i/(float)(n-1);
-            float a = a0 + u*(a1-a0);
-            float rx = p1->x + cosf(a) * rw;
-            float ry = p1->y + sinf(a) * rw;
+            float rx = p1->x + ax * rw;
+            float ry = p1->y + ay * rw;
             nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
             nvg__vset(dst, rx, ry, ru,1); dst++;
+            t = ax*cs - ay*sn;
+            ay = ax*sn + ay*cs;
+            ax = t;
         }
 
         nvg__vset(dst, lx1, ly1, lu,1); dst++;
         nvg__vset(dst, p1->x - dlx1*rw, p1->y - dly1*rw, ru,1); dst++;
 
     } else {
-        float rx0,ry0,rx1,ry1,a0,a1;
+        float rx0,ry0,rx1,ry1;
         nvg__chooseBevel(p1->flags & NVG_PR_INNERBEVEL, p0, p1, -rw, &rx0,&ry0, &rx1,&ry1);
-        a0 = atan2f(dly0, dlx0);
-        a1 = atan2f(dly1, dlx1);
-        if (a1 < a0) a1 += NVG_PI*2;
+        // Counter clockwise angle from dl0 to dl1, in [0, 2*PI).
+        da = atan2f(dlx0*dly1 - dly0*dlx1, dlx0*dlx1 + dly0*dly1);
+        if (da < 0.0f) da += NVG_PI*2;
 
         nvg__vset(dst, p1->x + dlx0*rw, p1->y + dly0*rw, lu,1); dst++;
         nvg__vset(dst, rx0, ry0, ru,1); dst++;
 
-        n = nvg__clampi((int)ceilf(((a1 - a0) / NVG_PI) * ncap), 2, ncap);
+        n = nvg__clampi((int)ceilf((da / NVG_PI) * ncap), 2, ncap);
+        cs = cosf(da / (n-1));
+        sn = sinf(da / (n-1));
+        ax = dlx0;
+        ay = dly0;
         for (i = 0; i < n; i++) {
-            float u = i/(float)(n-1);
-            float a = a0 + u*(a1-a0);
-            float lx = p1->x + cosf(a) * lw;
-            float ly = p1->y + sinf(a) * lw;
+            float lx = p1->x + ax * lw;
+            float ly = p1->y + ay * lw;
             nvg__vset(dst, lx, ly, lu,1); dst++;
             nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
+            t = ax*cs - ay*sn;
+            ay = ax*sn + ay*cs;
+            ax = t;
         }
 
         nvg__vset(dst, p1->x + dlx1*rw, p1->y + dly1*rw, lu,1); dst++;
@@ -1758,7 +1918,7 @@ static NVGvertex* nvg__buttCapEnd(NVGvertex* dst, NVGpoint* p,
 }
 
 
-static NVGvertex* nvg__roundCapStart(NVGvertex* dst, NVGpoint* p,
+static NVGvertex* nvg__roundCapStart(NVGvertex* dst, NVGpoint* p, const float* caps,
                                      float dx, float dy, float w, int ncap,
                                      float aa, float u0, float u1)
 {
@@ -1769,8 +1929,7 @@ static NVGvertex* nvg__roundCapStart(NVGvertex* dst, NVGpoint* p,
     float dly = -dx;
     NVG_NOTUSED(aa);
     for (i = 0; i < ncap; i++) {
-        float a = i/(float)(ncap-1)*NVG_PI;
-        float ax = cosf(a) * w, ay = sinf(a) * w;
+        float ax = caps[i*2] * w, ay = caps[i*2+1] * w;
         nvg__vset(dst, px - dlx*ax - dx*ay, py - dly*ax - dy*ay, u0,1); dst++;
         nvg__vset(dst, px, py, 0.5f,1); dst++;
     }
@@ -1779,7 +1938,7 @@ static NVGvertex* nvg__roundCapStart(NVGvertex* dst, NVGpoint* p,
     return dst;
 }
 
-static NVGvertex* nvg__roundCapEnd(NVGvertex* dst, NVGpoint* p,
+static NVGvertex* nvg__roundCapEnd(NVGvertex* dst, NVGpoint* p, const float* caps,
                                    float dx, float dy, float w, int ncap,
                                    float aa, float u0, float u1)
 {
@@ -1792,8 +1951,7 @@ static NVGvertex* nvg__roundCapEnd(NVGvertex* dst, NVGpoint* p,
     nvg__vset(dst, px + dlx*w, py + dly*w, u0,1); dst++;
     nvg__vset(dst, px - dlx*w, py - dly*w, u1,1); dst++;
     for (i = 0; i < ncap; i++) {
-        float a = i/(float)(ncap-1)*NVG_PI;
-        float ax = cosf(a) * w, ay = sinf(a) * w;
+        float ax = caps[i*2] * w, ay = caps[i*2+1] * w;
         nvg__vset(dst, px, py, 0.5f,1); dst++;
         nvg__vset(dst, px - dlx*ax + dx*ay, py - dly*ax + dy*ay, u0,1); dst++;
     }
@@ -1801,11 +1959,151 @@ static NVGvertex* nvg__roundCapEnd(NVGvertex* dst, NVGpoint* p,
 }
 
 
+static void nvg__calculateJoin(NVGpoint* p0, NVGpoint* p1, float iw, int forceBevel, float miterLimit, NVGpath* path, int* nleft)
+{
+    float dlx0, dly0, dlx1, dly1, dmr2, cross, limit;
+    dlx0 = p0->dy;
+    dly0 = -p0->dx;
+    dlx1 = p1->dy;
+    dly1 = -p1->dx;
+    // Calculate extrusions
+    p1->dmx = (dlx0 + dlx1) * 0.5f;
+    p1->dmy = (dly0 + dly1) * 0.5f;
+    dmr2 = p1->dmx*p1->dmx + p1->dmy*p1->dmy;
+    if (dmr2 > 0.000001f) {
+        float scale = 1.0f / dmr2;
+        if (scale > 600.0f) {
+            scale = 600.0f;
+        }
+        p1->dmx *= scale;
+        p1->dmy *= scale;
+    }
+
+    // Clear flags, but keep the corner.
+    p1->flags = (p1->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
+
+    // Keep track of left turns.
+    cross = p1->dx * p0->dy - p0->dx * p1->dy;
+    if (cross > 0.0f) {
+        (*nleft)++;
+        p1->flags |= NVG_PT_LEFT;
+    }
+
+    // Calculate if we should use bevel or miter for inner join.
+    limit = nvg__maxf(1.01f, nvg__minf(p0->len, p1->len) * iw);
+    if ((dmr2 * limit*limit) < 1.0f)
+        p1->flags |= NVG_PR_INNERBEVEL;
+
+    // Check to see if the corner needs to be beveled.
+    if (p1->flags & NVG_PT_CORNER) {
+        if ((dmr2 * miterLimit*miterLimit) < 1.0f || forceBevel) {
+            p1->flags |= NVG_PT_BEVEL;
+        }
+    }
+
+    if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
+        path->nbevel++;
+}
+
+#if NVG_SSE2 || NVG_NEON
+
+// Same as nvg__calculateJoin for the 4 points after p0, with the same float operations in the same order,
+// so the result is bit-identical. The points stay array-of-structs, the fields are transposed on load.
+static void nvg__calculateJoins4(NVGpoint* p0, float iw, int forceBevel, float miterLimit, NVGpath* path, int* nleft)
+{
+    NVGpoint* p1 = p0 + 1;
+    float dmx[4], dmy[4];
+    int left, inner, bevel, k;
+
+#if NVG_SSE2
+    __m128 dx0 = _mm_setr_ps(p0[0].dx, p0[1].dx, p0[2].dx, p0[3].dx);
+    __m128 dy0 = _mm_setr_ps(p0[0].dy, p0[1].dy, p0[2].dy, p0[3].dy);
+    __m128 len0 = _mm_setr_ps(p0[0].len, p0[1].len, p0[2].len, p0[3].len);
+    __m128 dx1 = _mm_setr_ps(p1[0].dx, p1[1].dx, p1[2].dx, p1[3].dx);
+    __m128 dy1 = _mm_setr_ps(p1[0].dy, p1[1].dy, p1[2].dy, p1[3].dy);
+    __m128 len1 = _mm_setr_ps(p1[0].len, p1[1].len, p1[2].len, p1[3].len);
+    __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 miter = _mm_set1_ps(miterLimit);
+    __m128 mx, my, dmr2, scale, big, limit;
+
+    mx = _mm_mul_ps(_mm_add_ps(dy0, dy1), half);
+    my = _mm_mul_ps(_mm_add_ps(_mm_xor_ps(dx0, sign), _mm_xor_ps(dx1, sign)), half);
+    dmr2 = _mm_add_ps(_mm_mul_ps(mx, mx), _mm_mul_ps(my, my));
+    big = _mm_cmpgt_ps(dmr2, _mm_set1_ps(0.000001f));
+    scale = _mm_min_ps(_mm_div_ps(one, dmr2), _mm_set1_ps(600.0f));
+    mx = _mm_or_ps(_mm_and_ps(big, _mm_mul_ps(mx, scale)), _mm_andnot_ps(big, mx));
+    my = _mm_or_ps(_mm_and_ps(big, _mm_mul_ps(my, scale)), _mm_andnot_ps(big, my));
+    _mm_storeu_ps(dmx, mx);
+    _mm_storeu_ps(dmy, my);
+
+    left = _mm_movemask_ps(_mm_cmpgt_ps(_mm_sub_ps(_mm_mul_ps(dx1, dy0), _mm_mul_ps(dx0, dy1)), _mm_setzero_ps()));
+    limit = _mm_max_ps(_mm_set1_ps(1.01f), _mm_mul_ps(_mm_min_ps(len0, len1), _mm_set1_ps(iw)));
+    inner = _mm_movemask_ps(_mm_cmplt_ps(_mm_mul_ps(_mm_mul_ps(dmr2, limit), limit), one));
+    bevel = _mm_movemask_ps(_mm_cmplt_ps(_mm_mul_ps(_mm_mul_ps(dmr2, miter), miter), one));
+#else
+    float t[4];
+    static const uint32_t lanes[4] = { 1, 2, 4, 8 };
+    uint32x4_t bits = vld1q_u32(lanes);
+    float32x4_t dx0, dy0, len0, dx1, dy1, len1, mx, my, dmr2, scale, limit;
+    float32x4_t half = vdupq_n_f32(0.5f);
+    float32x4_t one = vdupq_n_f32(1.0f);
+    float32x4_t miter = vdupq_n_f32(miterLimit);
+    uint32x4_t big;
+
+    t[0] = p0[0].dx; t[1] = p0[1].dx; t[2] = p0[2].dx; t[3] = p0[3].dx; dx0 = vld1q_f32(t);
+    t[0] = p0[0].dy; t[1] = p0[1].dy; t[2] = p0[2].dy; t[3] = p0[3].dy; dy0 = vld1q_f32(t);
+    t[0] = p0[0].len; t[1] = p0[1].len; t[2] = p0[2].len; t[3] = p0[3].len; len0 = vld1q_f32(t);
+    t[0] = p1[0].dx; t[1] = p1[1].dx; t[2] = p1[2].dx; t[3] = p1[3].dx; dx1 = vld1q_f32(t);
+    t[0] = p1[0].dy; t[1] = p1[1].dy; t[2] = p1[2].dy; t[3] = p1[3].dy; dy1 = vld1q_f32(t);
+    t[0] = p1[0].len; t[1] = p1[1].len; t[2] = p1[2].len; t[3] = p1[3].len; len1 = vld1q_f32(t);
+
+    mx = vmulq_f32(vaddq_f32(dy0, dy1), half);
+    my = vmulq_f32(vaddq_f32(vnegq_f32(dx0), vnegq_f32(dx1)), half);
+    dmr2 = vaddq_f32(vmulq_f32(mx, mx), vmulq_f32(my, my));
+    big = vcgtq_f32(dmr2, vdupq_n_f32(0.000001f));
+    scale = vminq_f32(vdivq_f32(one, dmr2), vdupq_n_f32(600.0f));
+    mx = vbslq_f32(big, vmulq_f32(mx, scale), mx);
+    my = vbslq_f32(big, vmulq_f32(my, scale), my);
+    vst1q_f32(dmx, mx);
+    vst1q_f32(dmy, my);
+
+    left = (int)vaddvq_u32(vandq_u32(vcgtq_f32(vsubq_f32(vmulq_f32(dx1, dy0), vmulq_f32(dx0, dy1)), vdupq_n_f32(0.0f)), bits));
+    limit = vmaxq_f32(vdupq_n_f32(1.01f), vmulq_f32(vminq_f32(len0, len1), vdupq_n_f32(iw)));
+    inner = (int)vaddvq_u32(vandq_u32(vcltq_f32(vmulq_f32(vmulq_f32(dmr2, limit), limit), one), bits));
+    bevel = (int)vaddvq_u32(vandq_u32(vcltq_f32(vmulq_f32(vmulq_f32(dmr2, miter), miter), one), bits));
+#endif
+
+    if (forceBevel) bevel = 0xf;
+
+    for (k = 0; k < 4; k++) {
+        NVGpoint* p = &p1[k];
+        unsigned char flags = (p->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
+        p->dmx = dmx[k];
+        p->dmy = dmy[k];
+        if (left & (1 << k)) {
+            (*nleft)++;
+            flags |= NVG_PT_LEFT;
+        }
+        if (inner & (1 << k))
+            flags |= NVG_PR_INNERBEVEL;
+        if ((flags & NVG_PT_CORNER) && (bevel & (1 << k)))
+            flags |= NVG_PT_BEVEL;
+        if ((flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
+            path->nbevel++;
+        p->flags = flags;
+    }
+}
+
+#endif
+
 static void nvg__calculateJoins(NVGcontext* ctx, float w, int lineJoin, float miterLimit)
 {
     NVGpathCache* cache = ctx->cache;
     int i, j;
     float iw = 0.0f;
+    int forceBevel = lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND;
 
     if (w > 0.0f) iw = 1.0f / w;
 
@@ -1813,57 +2111,21 @@ static void nvg__calculateJoins(NVGcontext* ctx, float w, int lineJoin, float mi
     for (i = 0; i < cache->npaths; i++) {
         NVGpath* path = &cache->paths[i];
         NVGpoint* pts = &cache->points[path->first];
-        NVGpoint* p0 = &pts[path->count-1];
-        NVGpoint* p1 = &pts[0];
         int nleft = 0;
 
         path->nbevel = 0;
 
-        for (j = 0; j < path->count; j++) {
-            float dlx0, dly0, dlx1, dly1, dmr2, cross, limit;
-            dlx0 = p0->dy;
-            dly0 = -p0->dx;
-            dlx1 = p1->dy;
-            dly1 = -p1->dx;
-            // Calculate extrusions
-            p1->dmx = (dlx0 + dlx1) * 0.5f;
-            p1->dmy = (dly0 + dly1) * 0.5f;
-            dmr2 = p1->dmx*p1->dmx + p1->dmy*p1->dmy;
-            if (dmr2 > 0.000001f) {
-                float scale = 1.0f / dmr2;
-                if (scale > 600.0f) {
-                    scale = 600.0f;
-                }
-                p1->dmx *= scale;
-                p1->dmy *= scale;
-            }
-
-            // Clear flags, but keep the corner.
-            p1->flags = (p1->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
-
-            // Keep track of left turns.
-            cross = p1->dx * p0->dy - p0->dx * p1->dy;
-            if (cross > 0.0f) {
-                nleft++;
-                p1->flags |= NVG_PT_LEFT;
-            }
-
-            // Calculate if we should use bevel or miter for inner join.
-            limit = nvg__maxf(1.01f, nvg__minf(p0->len, p1->len) * iw);
-            if ((dmr2 * limit*limit) < 1.0f)
-                p1->flags |= NVG_PR_INNERBEVEL;
-
-            // Check to see if the corner needs to be beveled.
-            if (p1->flags & NVG_PT_CORNER) {
-                if ((dmr2 * miterLimit*miterLimit) < 1.0f || lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND) {
-                    p1->flags |= NVG_PT_BEVEL;
-                }
-            }
-
-            if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
-                path->nbevel++;
-
-            p0 = p1++;
+        // Each point only writes its own extrusion and flags, and reads the direction of the previous point,
+        // so the first point (which wraps around) is done first, and the rest 4 at a time if possible.
+        if (path->count > 0) {
+            nvg__calculateJoin(&pts[path->count-1], &pts[0], iw, forceBevel, miterLimit, path, &nleft);
+            j = 1;
+#if NVG_SSE2 || NVG_NEON
+            for (; j + 4 <= path->count; j += 4)
+                nvg__calculateJoins4(&pts[j-1], iw, forceBevel, miterLimit, path, &nleft);
+#endif
+            for (; j < path->count; j++)
+                nvg__calculateJoin(&pts[j-1], &pts[j], iw, forceBevel, miterLimit, path, &nleft);
         }
 
         path->convex = (nleft == path->count) ? 1 : 0;
@@ -1876,6 +2138,7 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
     NVGpathCache* cache = ctx->cache;
     NVGvertex* verts;
     NVGvertex* dst;
+    const float* caps = NULL;
     int cverts, i, j;
     float aa = fringe;//ctx->fringeWidth;
     float u0 = 0.0f, u1 = 1.0f;
@@ -1913,6 +2176,11 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
     verts = nvg__allocTempVerts(ctx, cverts);
     if (verts == NULL) return 0;
 
+    if (lineCap == NVG_ROUND) {
+        caps = nvg__capTable(cache, ncap);
+        if (caps == NULL) return 0;
+    }
+
     for (i = 0; i < cache->npaths; i++) {
         NVGpath* path = &cache->paths[i];
         NVGpoint* pts = &cache->points[path->first];
@@ -1953,7 +2221,7 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
             else if (lineCap == NVG_BUTT || lineCap == NVG_SQUARE)
                 dst = nvg__buttCapStart(dst, p0, dx, dy, w, w-aa, aa, u0, u1);
             else if (lineCap == NVG_ROUND)
-                dst = nvg__roundCapStart(dst, p0, dx, dy, w, ncap, aa, u0, u1);
+                dst = nvg__roundCapStart(dst, p0, caps, dx, dy, w, ncap, aa, u0, u1);
         }
 
         for (j = s; j < e; ++j) {
@@ -1984,7 +2252,7 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
             else if (lineCap == NVG_BUTT || lineCap == NVG_SQUARE)
                 dst = nvg__buttCapEnd(dst, p1, dx, dy, w, w-aa, aa, u0, u1);
             else if (lineCap == NVG_ROUND)
-                dst = nvg__roundCapEnd(dst, p1, dx, dy, w, ncap, aa, u0, u1);
+                dst = nvg__roundCapEnd(dst, p1, caps, dx, dy, w, ncap, aa, u0, u1);
         }
 
         path->nstroke = (int)(dst - verts);
@@ -1995,6 +2263,99 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
     return 1;
 }
 
+// Hairline is not wider than the fringe, so the joins are not visible.
+// Each point emits one pair of vertices along the averaged normal, without calculateJoins,
+// the open path ends with the same caps (and fringe) as nvg__expandStroke.
+static int nvg__expandHairline(NVGcontext* ctx, float w, float fringe, int lineCap)
+{
+    NVGpathCache* cache = ctx->cache;
+    NVGvertex* verts;
+    NVGvertex* dst;
+    const float* caps = NULL;
+    int cverts, i, j;
+    float aa = fringe;
+    float u0 = 0.0f, u1 = 1.0f;
+    int ncap = nvg__curveDivs(w, NVG_PI, ctx->tessTol);	// Calculate divisions per half circle.
+
+    w += aa * 0.5f;
+
+    // Disable the gradient used for antialiasing when antialiasing is not used.
+    if (aa == 0.0f) {
+        u0 = 0.5f;
+        u1 = 0.5f;
+    }
+
+    cverts = 0;
+    for (i = 0; i < cache->npaths; i++) {
+        cverts += cache->paths[i].count*2 + 2; // plus one for loop
+        if (cache->paths[i].closed == 0)
+            cverts += lineCap == NVG_ROUND ? (ncap*2 + 2)*2 : 4; // space for caps
+    }
+
+    verts = nvg__allocTempVerts(ctx, cverts);
+    if (verts == NULL) return 0;
+
+    if (lineCap == NVG_ROUND) {
+        caps = nvg__capTable(cache, ncap);
+        if (caps == NULL) return 0;
+    }
+
+    for (i = 0; i < cache->npaths; i++) {
+        NVGpath* path = &cache->paths[i];
+        NVGpoint* pts = &cache->points[path->first];
+        int n = path->count;
+        int loop = path->closed;
+        float d = lineCap == NVG_BUTT ? -aa*0.5f : w-aa;
+
+        path->fill = 0;
+        path->nfill = 0;
+        path->nbevel = 0;
+        dst = verts;
+        path->stroke = dst;
+
+        if (n < 2) {
+            path->nstroke = 0;
+            continue;
+        }
+
+        // the segment from p0 to p1 is in p0->dx, p0->dy
+        if (!loop && lineCap == NVG_ROUND)
+            dst = nvg__roundCapStart(dst, &pts[0], caps, pts[0].dx, pts[0].dy, w, ncap, aa, u0, u1);
+        else if (!loop)
+            dst = nvg__buttCapStart(dst, &pts[0], pts[0].dx, pts[0].dy, w, d, aa, u0, u1);
+
+        for (j = loop ? 0 : 1; j < (loop ? n : n-1); j++) {
+            NVGpoint* p0 = &pts[j > 0 ? j-1 : n-1];
+            NVGpoint* p1 = &pts[j];
+
+            // Keep the width at the turn, but not more than twice for the sharp turn.
+            float dlx = (p0->dy + p1->dy) * 0.5f;
+            float dly = (-p0->dx - p1->dx) * 0.5f;
+            float dmr2 = nvg__maxf(dlx*dlx + dly*dly, 0.25f);
+            dlx /= dmr2;
+            dly /= dmr2;
+
+            nvg__vset(dst, p1->x + dlx*w, p1->y + dly*w, u0,1); dst++;
+            nvg__vset(dst, p1->x - dlx*w, p1->y - dly*w, u1,1); dst++;
+        }
+
+        if (loop) {
+            // Loop it
+            nvg__vset(dst, path->stroke[0].x, path->stroke[0].y, u0,1); dst++;
+            nvg__vset(dst, path->stroke[1].x, path->stroke[1].y, u1,1); dst++;
+        } else if (lineCap == NVG_ROUND) {
+            dst = nvg__roundCapEnd(dst, &pts[n-1], caps, pts[n-2].dx, pts[n-2].dy, w, ncap, aa, u0, u1);
+        } else {
+            dst = nvg__buttCapEnd(dst, &pts[n-1], pts[n-2].dx, pts[n-2].dy, w, d, aa, u0, u1);
+        }
+
+        path->nstroke = (int)(dst - verts);
+        verts = dst;
+    }
+
+    return 1;
+}
+
 static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLimit)
 {
     NVGpathCache* cache = ctx->cache;
@@ -2117,6 +2478,63 @@ static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLi
 
 
 // Draw
+NVGsnapshot* nvgInternalSnapshot(NVGcontext* ctx)
+{
+    NVGstate* state = nvg__getState(ctx);
+    int ndashes = state->dashArray != NULL ? state->dashLen : 0;
+    NVGsnapshot* snapshot;
+
+    // the commands and dashes are kept in the same allocation
+    snapshot = (NVGsnapshot*)malloc(sizeof(NVGsnapshot) + sizeof(float) * (ctx->ncommands + ndashes));
+    if (snapshot == NULL) return NULL;
+
+    snapshot->state = *state;
+    snapshot->commands = (float*)(snapshot + 1);
+    snapshot->ncommands = ctx->ncommands;
+    memcpy(snapshot->commands, ctx->commands, sizeof(float) * ctx->ncommands);
+    if (ndashes > 0) {
+        snapshot->state.dashArray = snapshot->commands + ctx->ncommands;
+        memcpy(snapshot->state.dashArray, state->dashArray, sizeof(float) * ndashes);
+    }
+
+    snapshot->commandx = ctx->commandx;
+    snapshot->commandy = ctx->commandy;
+    snapshot->tessTol = ctx->tessTol;
+    snapshot->distTol = ctx->distTol;
+    snapshot->fringeWidth = ctx->fringeWidth;
+    snapshot->devicePxRatio = ctx->devicePxRatio;
+    snapshot->simplifyTol = ctx->simplifyTol;
+    snapshot->cullEnabled = ctx->cullEnabled;
+    memcpy(snapshot->cullBounds, ctx->cullBounds, sizeof(snapshot->cullBounds));
+    return snapshot;
+}
+
+void nvgInternalRestore(NVGcontext* ctx, const NVGsnapshot* snapshot)
+{
+    nvgBeginPath(ctx);
+    *nvg__getState(ctx) = snapshot->state;
+
+    if (nvg__allocCommands(ctx, snapshot->ncommands) != NULL) {
+        memcpy(ctx->commands, snapshot->commands, sizeof(float) * snapshot->ncommands);
+        ctx->ncommands = snapshot->ncommands;
+    }
+
+    ctx->commandx = snapshot->commandx;
+    ctx->commandy = snapshot->commandy;
+    ctx->tessTol = snapshot->tessTol;
+    ctx->distTol = snapshot->distTol;
+    ctx->fringeWidth = snapshot->fringeWidth;
+    ctx->devicePxRatio = snapshot->devicePxRatio;
+    ctx->simplifyTol = snapshot->simplifyTol;
+    ctx->cullEnabled = snapshot->cullEnabled;
+    memcpy(ctx->cullBounds, snapshot->cullBounds, sizeof(ctx->cullBounds));
+}
+
+void nvgInternalDeleteSnapshot(NVGsnapshot* snapshot)
+{
+    free(snapshot);
+}
+
 void nvgBeginPath(NVGcontext* ctx)
 {
     ctx->ncommands = 0;
@@ -2222,7 +2640,7 @@ void nvgPathWinding(NVGcontext* ctx, int dir)
 
 void nvgArc(NVGcontext* ctx, float cx, float cy, float r, float a0, float a1, int dir)
 {
-    float a = 0, da = 0, hda = 0, kappa = 0;
+    float a = 0, da = 0, hda = 0, chda = 0, shda = 0, kappa = 0, cs = 0, sn = 0;
     float dx = 0, dy = 0, x = 0, y = 0, tanx = 0, tany = 0;
     float px = 0, py = 0, ptanx = 0, ptany = 0;
     float vals[3 + 5*7 + 100];
@@ -2248,16 +2666,26 @@ void nvgArc(NVGcontext* ctx, float cx, float cy, float r, float a0, float a1, in
     // Split arc into max 90 degree segments.
     ndivs = nvg__maxi(1, nvg__mini((int)(nvg__absf(da) / (NVG_PI*0.5f) + 0.5f), 5));
     hda = (da / (float)ndivs) / 2.0f;
-    kappa = nvg__absf(4.0f / 3.0f * (1.0f - nvg__cosf(hda)) / nvg__sinf(hda));
+    chda = nvg__cosf(hda);
+    shda = nvg__sinf(hda);
+    kappa = nvg__absf(4.0f / 3.0f * (1.0f - chda) / shda);
 
     if (dir == NVG_CCW)
         kappa = -kappa;
 
+    // Rotate by the segment angle (twice of hda) instead of sin and cos of each end point.
+    cs = chda*chda - shda*shda;
+    sn = 2.0f*shda*chda;
+    dx = nvg__cosf(a0);
+    dy = nvg__sinf(a0);
+
     nvals = 0;
     for (i = 0; i <= ndivs; i++) {
-        a = a0 + da * (i/(float)ndivs);
-        dx = nvg__cosf(a);
-        dy = nvg__sinf(a);
+        if (i > 0) {
+            a = dx*cs - dy*sn;
+            dy = dx*sn + dy*cs;
+            dx = a;
+        }
         x = cx + dx*r;
         y = cy + dy*r;
         tanx = -dy*r*kappa;
@@ -2348,6 +2776,54 @@ void nvgCircle(NVGcontext* ctx, float cx, float cy, float r)
     nvgEllipse(ctx, cx,cy, r,r);
 }
 
+static void nvg__appendPolygon(NVGcontext* ctx, const float* fpts, const double* dpts, int npts, int close)
+{
+    NVGstate* state = nvg__getState(ctx);
+    const float* t = state->xform;
+    float* dst;
+    float x, y;
+    int i, nvals;
+
+    if (npts < 2) return;
+
+    // Reserve all commands at once and transform the points in place,
+    // this avoids the per segment overhead of nvg__appendCommands().
+    nvals = npts*3 + (close ? 1 : 0);
+    dst = nvg__allocCommands(ctx, nvals);
+    if (dst == NULL) return;
+
+    for (i = 0; i < npts; i++) {
+        if (fpts != NULL) {
+            x = fpts[i*2];
+            y = fpts[i*2+1];
+        } else {
+            x = (float)dpts[i*2];
+            y = (float)dpts[i*2+1];
+        }
+        dst[0] = (float)(i == 0 ? NVG_MOVETO : NVG_LINETO);
+        dst[1] = x*t[0] + y*t[2] + t[4];
+        dst[2] = x*t[1] + y*t[3] + t[5];
+        dst += 3;
+    }
+
+    if (close)
+        dst[0] = NVG_CLOSE;
+
+    ctx->commandx = x;
+    ctx->commandy = y;
+    ctx->ncommands += nvals;
+}
+
+void nvgPolygon(NVGcontext* ctx, const float* pts, int npts, int close)
+{
+    nvg__appendPolygon(ctx, pts, NULL, npts, close);
+}
+
+void nvgPolygonDouble(NVGcontext* ctx, const double* pts, int npts, int close)
+{
+    nvg__appendPolygon(ctx, NULL, pts, npts, close);
+}
+
 void nvgDebugDumpPathCache(NVGcontext* ctx)
 {
     const NVGpath* path;
@@ -2370,6 +2846,32 @@ void nvgDebugDumpPathCache(NVGcontext* ctx)
     }
 }
 
+// Returns 1 if the flattened paths, grown by margin, are entirely outside of the cull bounds or the scissor.
+static int nvg__isCulled(NVGcontext* ctx, float margin)
+{
+    NVGstate* state = nvg__getState(ctx);
+    const float* b = ctx->cache->bounds;
+    int culled = 0;
+
+    if (ctx->cullEnabled) {
+        const float* c = ctx->cullBounds;
+        culled = c[0] > c[2] || c[1] > c[3] || b[0] - margin > c[2] || b[2] + margin < c[0] || b[1] - margin > c[3] || b[3] + margin < c[1];
+    }
+
+    if (!culled && state->scissor.extent[0] > -0.5f) {
+        // axis aligned bounds of the (transformed) scissor rect
+        const float* t = state->scissor.xform;
+        float ex = state->scissor.extent[0];
+        float ey = state->scissor.extent[1];
+        float hw = nvg__absf(t[0]) * ex + nvg__absf(t[2]) * ey;
+        float hh = nvg__absf(t[1]) * ex + nvg__absf(t[3]) * ey;
+        culled = b[0] - margin > t[4] + hw || b[2] + margin < t[4] - hw || b[1] - margin > t[5] + hh || b[3] + margin < t[5] - hh;
+    }
+
+    if (culled) ctx->culledCount++;
+    return culled;
+}
+
 void nvgFill(NVGcontext* ctx)
 {
     NVGstate* state = nvg__getState(ctx);
@@ -2378,6 +2880,7 @@ void nvgFill(NVGcontext* ctx)
     int i;
 
     nvg__flattenPaths(ctx, 0);
+    if (nvg__isCulled(ctx, ctx->fringeWidth)) return;
     if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
         nvg__expandFill(ctx, ctx->fringeWidth, NVG_MITER, 2.4f);
     else
@@ -2406,9 +2909,9 @@ void nvgStroke(NVGcontext* ctx)
     float strokeWidth = nvg__clampf(state->strokeWidth * scale, 0.0f, 200.0f);
     NVGpaint strokePaint = state->stroke;
     const NVGpath* path;
+    int hairline = strokeWidth <= ctx->fringeWidth;
     int i;
 
-
     if (strokeWidth < ctx->fringeWidth) {
         // If the stroke width is less than pixel size, use alpha to emulate coverage.
         // Since coverage is area, scale by alpha*alpha.
@@ -2424,7 +2927,13 @@ void nvgStroke(NVGcontext* ctx)
 
     nvg__flattenPaths(ctx, state->dashLen > 0);
 
-    if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
+    // Miter joins may reach miterLimit * half width, square caps sqrt(2) * half width.
+    if (nvg__isCulled(ctx, strokeWidth*0.5f * (state->lineJoin == NVG_MITER ? nvg__maxf(state->miterLimit, 1.5f) : 1.5f) + ctx->fringeWidth))
+        return;
+
+    if (hairline)
+        nvg__expandHairline(ctx, strokeWidth*0.5f, ctx->params.edgeAntiAlias && state->shapeAntiAlias ? ctx->fringeWidth : 0.0f, state->lineCap);
+    else if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
         nvg__expandStroke(ctx, strokeWidth*0.5f, ctx->fringeWidth, state->lineCap, state->lineJoin, state->miterLimit);
     else
         nvg__expandStroke(ctx, strokeWidth*0.5f, 0.0f, state->lineCap, state->lineJoin, state->miterLimit);
@@ -515,6 +515,13 @@ void nvgEllipse(NVGcontext* ctx, float cx, float cy, float rx, float ry);
 // Creates new circle shaped sub-path.
 void nvgCircle(NVGcontext* ctx, float cx, float cy, float r);
 
+// Creates new polyline shaped sub-path from npts points packed as x,y pairs.
+// If close is non-zero, the sub-path is closed.
+void nvgPolygon(NVGcontext* ctx, const float* pts, int npts, int close);
+
+// Same as nvgPolygon(), but the points are packed as double precision x,y pairs.
+void nvgPolygonDouble(NVGcontext* ctx, const double* pts, int npts, int close);
+
 // Fills the current path with current fill style.
 void nvgFill(NVGcontext* ctx);
 
@@ -696,6 +703,23 @@ NVGparams* nvgInternalParams(NVGcontext* ctx);
 
 int nvgInternalCommands(NVGcontext* ctx, float** buffer);
 
+// Fill and stroke entirely outside of bounds [minx, miny, maxx, maxy] are dropped before tessellation.
+// Empty bounds (minx > maxx) culls everything, NULL to disable.
+void nvgInternalCullBounds(NVGcontext* ctx, const float* bounds);
+
+// Polylines are simplified within tol (in device pixels) when flattened, 0 to disable.
+void nvgInternalSimplifyTolerance(NVGcontext* ctx, float tol);
+
+// Counters since nvgBeginFrame(), any of the output can be NULL.
+void nvgInternalStats(NVGcontext* ctx, int* drawCallCount, int* triCount, int* culledCount);
+
+// The current state and path commands, so the fill or stroke can be done on another context (or thread).
+// The restored context must not be used after the snapshot is deleted, since the dash array is kept there.
+typedef struct NVGsnapshot NVGsnapshot;
+NVGsnapshot* nvgInternalSnapshot(NVGcontext* ctx);
+void nvgInternalRestore(NVGcontext* ctx, const NVGsnapshot* snapshot);
+void nvgInternalDeleteSnapshot(NVGsnapshot* snapshot);
+
 // Debug function to dump cached path data.
 void nvgDebugDumpPathCache(NVGcontext* ctx);
 
@@ -0,0 +1,25 @@
+#version 440
+
+layout(std140, binding = 0) uniform frag {
+    mat4 qt_Matrix;
+    float qt_Opacity;
+    vec4 innerColor;
+    mat3 scissorMatrix;
+    vec2 scissorExtent;
+    vec2 scissorScale;
+};
+
+layout(location = 1) in vec2 fpos;
+layout(location = 0) out vec4 outColor;
+
+// Scissor - 1 inside of the scissor rect, fade out 1px at the edge, always 1 if there is no scissor
+float scissorMask(vec2 p) {
+    vec2 sc = abs((scissorMatrix * vec3(p, 1.0)).xy) - scissorExtent;
+    sc = vec2(0.5, 0.5) - sc * scissorScale;
+    return clamp(sc.x, 0.0, 1.0) * clamp(sc.y, 0.0, 1.0);
+}
+
+// Color without edge antialiasing
+void main() {
+    outColor = innerColor * (scissorMask(fpos) * qt_Opacity);
+}
@@ -0,0 +1,35 @@
+#version 440
+
+layout(std140, binding = 0) uniform frag {
+    mat4 qt_Matrix;
+    float qt_Opacity;
+    vec4 innerColor;
+    float strokeMultiply;
+    float strokeThreshold;
+    mat3 scissorMatrix;
+    vec2 scissorExtent;
+    vec2 scissorScale;
+};
+
+layout(location = 0) in vec2 ftcoord;
+layout(location = 1) in vec2 fpos;
+layout(location = 0) out vec4 outColor;
+
+// Stroke - from [0..1] to clipped pyramid, where the slope is 1px.
+float strokeMask() {
+    return min(1.0, (1.0 - abs(ftcoord.x * 2.0 - 1.0)) * strokeMultiply) * min(1.0, ftcoord.y);
+}
+
+// Scissor - 1 inside of the scissor rect, fade out 1px at the edge, always 1 if there is no scissor
+float scissorMask(vec2 p) {
+    vec2 sc = abs((scissorMatrix * vec3(p, 1.0)).xy) - scissorExtent;
+    sc = vec2(0.5, 0.5) - sc * scissorScale;
+    return clamp(sc.x, 0.0, 1.0) * clamp(sc.y, 0.0, 1.0);
+}
+
+// Color with edge antialiasing
+void main() {
+    float strokeAlpha = strokeMask();
+    if (strokeAlpha <= strokeThreshold) discard;
+    outColor = innerColor * (strokeAlpha * scissorMask(fpos) * qt_Opacity);
+}
@@ -0,0 +1,19 @@
+uniform highp float qt_Opacity;
+uniform highp vec4 innerColor;
+uniform highp mat3 scissorMatrix;
+uniform highp vec2 scissorExtent;
+uniform highp vec2 scissorScale;
+
+varying highp vec2 fpos;
+
+// Scissor - 1 inside of the scissor rect, fade out 1px at the edge, always 1 if there is no scissor
+highp float scissorMask(highp vec2 p) {
+    highp vec2 sc = abs((scissorMatrix * vec3(p, 1.0)).xy) - scissorExtent;
+    sc = vec2(0.5, 0.5) - sc * scissorScale;
+    return clamp(sc.x, 0.0, 1.0) * clamp(sc.y, 0.0, 1.0);
+}
+
+// Color without edge antialiasing
+void main() {
+    gl_FragColor = innerColor * (scissorMask(fpos) * qt_Opacity);
+}
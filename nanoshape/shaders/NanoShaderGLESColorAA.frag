@@ -0,0 +1,29 @@
+uniform highp float qt_Opacity;
+uniform highp vec4 innerColor;
+uniform highp float strokeMultiply;
+uniform highp float strokeThreshold;
+uniform highp mat3 scissorMatrix;
+uniform highp vec2 scissorExtent;
+uniform highp vec2 scissorScale;
+
+varying highp vec2 ftcoord;
+varying highp vec2 fpos;
+
+// Stroke - from [0..1] to clipped pyramid, where the slope is 1px.
+highp float strokeMask() {
+    return min(1.0, (1.0 - abs(ftcoord.x * 2.0 - 1.0)) * strokeMultiply) * min(1.0, ftcoord.y);
+}
+
+// Scissor - 1 inside of the scissor rect, fade out 1px at the edge, always 1 if there is no scissor
+highp float scissorMask(highp vec2 p) {
+    highp vec2 sc = abs((scissorMatrix * vec3(p, 1.0)).xy) - scissorExtent;
+    sc = vec2(0.5, 0.5) - sc * scissorScale;
+    return clamp(sc.x, 0.0, 1.0) * clamp(sc.y, 0.0, 1.0);
+}
+
+// Color with edge antialiasing
+void main() {
+    highp float strokeAlpha = strokeMask();
+    if (strokeAlpha <= strokeThreshold) discard;
+    gl_FragColor = innerColor * (strokeAlpha * scissorMask(fpos) * qt_Opacity);
+}
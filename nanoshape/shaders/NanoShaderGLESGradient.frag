@@ -0,0 +1,88 @@
+uniform highp float qt_Opacity;
+uniform highp mat3 paintMatrix;
+uniform highp vec4 innerColor;
+uniform highp vec4 outerColor;
+uniform highp vec4 textureRect;
+uniform highp vec2 extent;
+uniform highp float radius;
+uniform highp float feather;
+uniform highp float strokeMultiply;
+uniform highp float strokeThreshold;
+uniform int type;
+uniform int edgeAA;
+uniform highp mat3 scissorMatrix;
+uniform highp vec2 scissorExtent;
+uniform highp vec2 scissorScale;
+
+uniform sampler2D tex;
+
+varying highp vec2 ftcoord;
+varying highp vec2 fpos;
+
+highp float sdroundrect(highp vec2 pt, highp vec2 ext, highp float rad) {
+    highp vec2 ext2 = ext - vec2(rad, rad);
+    highp vec2 d = abs(pt) - ext2;
+    return min(max(d.x, d.y), 0.0) + length(max(d, 0.0)) - rad;
+}
+
+// Gradient ramp - one row of colors in the sub-rect of the texture
+highp vec4 ramp(highp float t) {
+    return texture2D(tex, textureRect.xy + vec2(clamp(t, 0.0, 1.0), 0.5) * textureRect.zw);
+}
+
+// Stroke - from [0..1] to clipped pyramid, where the slope is 1px.
+highp float strokeMask() {
+    return min(1.0, (1.0 - abs(ftcoord.x * 2.0 - 1.0)) * strokeMultiply) * min(1.0, ftcoord.y);
+}
+
+// Scissor - 1 inside of the scissor rect, fade out 1px at the edge, always 1 if there is no scissor
+highp float scissorMask(highp vec2 p) {
+    highp vec2 sc = abs((scissorMatrix * vec3(p, 1.0)).xy) - scissorExtent;
+    sc = vec2(0.5, 0.5) - sc * scissorScale;
+    return clamp(sc.x, 0.0, 1.0) * clamp(sc.y, 0.0, 1.0);
+}
+
+void main() {
+    highp vec4 color;
+    highp float strokeAlpha;
+
+    if (edgeAA == 1) {
+        strokeAlpha = strokeMask();
+        if (strokeAlpha <= strokeThreshold) discard;
+        strokeAlpha *= qt_Opacity;
+    } else {
+        strokeAlpha = qt_Opacity;
+    }
+
+    strokeAlpha *= scissorMask(fpos);
+
+    highp vec2 pt = (paintMatrix * vec3(fpos, 1.0)).xy;
+
+    if (type == 3) {
+        // GradientRamp
+        highp float d = (sdroundrect(pt, extent, radius) + feather * 0.5) / feather;
+        color = ramp(d) * innerColor;
+    } else if (type == 4) {
+        // ConicalGradient, counter-clockwise from +x
+        highp float t = atan(-pt.y, pt.x) * 0.15915494;
+        color = ramp(fract(t)) * innerColor;
+    } else if (type == 5) {
+        // FocalGradient, extent is the focal point
+        highp vec2 v = pt - extent;
+        highp float l = length(v);
+        highp float t = 0.0;
+        if (l > 0.0) {
+            // distance from the focal point to the circle along v
+            highp float b = dot(extent, v / l);
+            highp float s = sqrt(max(b * b - dot(extent, extent) + radius * radius, 0.0)) - b;
+            t = l / s;
+        }
+        color = ramp(t) * innerColor;
+    } else {
+        // Gradient
+        highp float d = clamp((sdroundrect(pt, extent, radius) + feather * 0.5) / feather, 0.0, 1.0);
+        color = mix(innerColor, outerColor, d);
+    }
+
+    gl_FragColor = color * strokeAlpha;
+}
@@ -0,0 +1,47 @@
+uniform highp float qt_Opacity;
+uniform highp mat3 paintMatrix;
+uniform highp vec4 innerColor;
+uniform highp vec4 textureRect;
+uniform highp vec2 extent;
+uniform highp float strokeMultiply;
+uniform highp float strokeThreshold;
+uniform int edgeAA;
+uniform highp mat3 scissorMatrix;
+uniform highp vec2 scissorExtent;
+uniform highp vec2 scissorScale;
+
+uniform sampler2D tex;
+
+varying highp vec2 ftcoord;
+varying highp vec2 fpos;
+
+// Stroke - from [0..1] to clipped pyramid, where the slope is 1px.
+highp float strokeMask() {
+    return min(1.0, (1.0 - abs(ftcoord.x * 2.0 - 1.0)) * strokeMultiply) * min(1.0, ftcoord.y);
+}
+
+// Scissor - 1 inside of the scissor rect, fade out 1px at the edge, always 1 if there is no scissor
+highp float scissorMask(highp vec2 p) {
+    highp vec2 sc = abs((scissorMatrix * vec3(p, 1.0)).xy) - scissorExtent;
+    sc = vec2(0.5, 0.5) - sc * scissorScale;
+    return clamp(sc.x, 0.0, 1.0) * clamp(sc.y, 0.0, 1.0);
+}
+
+void main() {
+    highp float strokeAlpha;
+
+    if (edgeAA == 1) {
+        strokeAlpha = strokeMask();
+        if (strokeAlpha <= strokeThreshold) discard;
+        strokeAlpha *= qt_Opacity;
+    } else {
+        strokeAlpha = qt_Opacity;
+    }
+
+    strokeAlpha *= scissorMask(fpos);
+
+    // map into the sub-rect of the texture, it could be in atlas
+    highp vec2 pt = (paintMatrix * vec3(fpos, 1.0)).xy / extent;
+    pt = textureRect.xy + clamp(pt, 0.0, 1.0) * textureRect.zw;
+    gl_FragColor = texture2D(tex, pt) * innerColor * strokeAlpha;
+}
@@ -0,0 +1,94 @@
+#version 440
+
+layout(std140, binding = 0) uniform frag {
+    mat4 qt_Matrix;
+    float qt_Opacity;
+    mat3 paintMatrix;
+    vec4 innerColor;
+    vec4 outerColor;
+    vec4 textureRect;
+    vec2 extent;
+    float radius;
+    float feather;
+    float strokeMultiply;
+    float strokeThreshold;
+    int type;
+    int edgeAA;
+    mat3 scissorMatrix;
+    vec2 scissorExtent;
+    vec2 scissorScale;
+};
+
+layout(binding = 1) uniform sampler2D tex;
+
+layout(location = 0) in vec2 ftcoord;
+layout(location = 1) in vec2 fpos;
+layout(location = 0) out vec4 outColor;
+
+float sdroundrect(vec2 pt, vec2 ext, float rad) {
+    vec2 ext2 = ext - vec2(rad, rad);
+    vec2 d = abs(pt) - ext2;
+    return min(max(d.x, d.y), 0.0) + length(max(d, 0.0)) - rad;
+}
+
+// Gradient ramp - one row of colors in the sub-rect of the texture
+vec4 ramp(float t) {
+    return texture(tex, textureRect.xy + vec2(clamp(t, 0.0, 1.0), 0.5) * textureRect.zw);
+}
+
+// Stroke - from [0..1] to clipped pyramid, where the slope is 1px.
+float strokeMask() {
+    return min(1.0, (1.0 - abs(ftcoord.x * 2.0 - 1.0)) * strokeMultiply) * min(1.0, ftcoord.y);
+}
+
+// Scissor - 1 inside of the scissor rect, fade out 1px at the edge, always 1 if there is no scissor
+float scissorMask(vec2 p) {
+    vec2 sc = abs((scissorMatrix * vec3(p, 1.0)).xy) - scissorExtent;
+    sc = vec2(0.5, 0.5) - sc * scissorScale;
+    return clamp(sc.x, 0.0, 1.0) * clamp(sc.y, 0.0, 1.0);
+}
+
+void main() {
+    vec4 color;
+    float strokeAlpha;
+
+    if (edgeAA == 1) {
+        strokeAlpha = strokeMask();
+        if (strokeAlpha <= strokeThreshold) discard;
+        strokeAlpha *= qt_Opacity;
+    } else {
+        strokeAlpha = qt_Opacity;
+    }
+
+    strokeAlpha *= scissorMask(fpos);
+
+    vec2 pt = (paintMatrix * vec3(fpos, 1.0)).xy;
+
+    if (type == 3) {
+        // GradientRamp
+        float d = (sdroundrect(pt, extent, radius) + feather * 0.5) / feather;
+        color = ramp(d) * innerColor;
+    } else if (type == 4) {
+        // ConicalGradient, counter-clockwise from +x
+        float t = atan(-pt.y, pt.x) * 0.15915494;
+        color = ramp(fract(t)) * innerColor;
+    } else if (type == 5) {
+        // FocalGradient, extent is the focal point
+        vec2 v = pt - extent;
+        float l = length(v);
+        float t = 0.0;
+        if (l > 0.0) {
+            // distance from the focal point to the circle along v
+            float b = dot(extent, v / l);
+            float s = sqrt(max(b * b - dot(extent, extent) + radius * radius, 0.0)) - b;
+            t = l / s;
+        }
+        color = ramp(t) * innerColor;
+    } else {
+        // Gradient
+        float d = clamp((sdroundrect(pt, extent, radius) + feather * 0.5) / feather, 0.0, 1.0);
+        color = mix(innerColor, outerColor, d);
+    }
+
+    outColor = color * strokeAlpha;
+}
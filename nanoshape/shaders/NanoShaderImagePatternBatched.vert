@@ -0,0 +1,24 @@
+#version 440
+
+layout(std140, binding = 0) uniform vert {
+    mat4 qt_Matrix;
+};
+
+layout(location = 0) in vec4 vertex;
+layout(location = 1) in vec2 tcoord;
+layout(location = 2) in vec2 pcoord;
+layout(location = 3) in vec4 prect;
+layout(location = 0) out vec2 ftcoord;
+layout(location = 1) out vec2 fpos;
+layout(location = 2) out vec2 fpcoord;
+layout(location = 3) flat out vec4 fprect;
+
+out gl_PerVertex { vec4 gl_Position; };
+
+void main() {
+    gl_Position = qt_Matrix * vertex;
+    ftcoord = tcoord;
+    fpos = vertex.xy;
+    fpcoord = pcoord;
+    fprect = prect;
+}
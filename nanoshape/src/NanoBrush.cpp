@@ -27,6 +27,13 @@
 #include "NanoBrush.h"
 #include "nanovg.h"
 
+#include <QCache>
+#include <QMutex>
+#include <QtMath>
+
+#include <algorithm>
+#include <array>
+
 //---------------------------------------------------------------------------
 
 static inline NVGcolor toNVGcolor(const QColor& color)
@@ -34,6 +41,80 @@ static inline NVGcolor toNVGcolor(const QColor& color)
     return nvgRGBAf(float(color.redF()), float(color.greenF()), float(color.blueF()), float(color.alphaF()));
 }
 
+static constexpr int GRADIENT_RAMP_SIZE = 256;
+static constexpr int GRADIENT_RAMP_CACHE_SIZE = 256;
+
+static QByteArray gradientRampKey(const QGradientStops& stops)
+{
+    QByteArray key;
+    key.reserve(stops.size() * int(sizeof(float) + sizeof(QRgba64)));
+    for (auto& stop : stops) {
+        auto pos = float(stop.first);
+        auto rgba = stop.second.rgba64();
+        key.append(reinterpret_cast<const char*>(&pos), sizeof(pos));
+        key.append(reinterpret_cast<const char*>(&rgba), sizeof(rgba));
+    }
+    return key;
+}
+
+// bake the stops into one row of premultiplied colors, same stops share the same image (and texture)
+static QImage gradientRamp(const QGradientStops& stops)
+{
+    static QMutex s_rampMutex;
+    static QCache<QByteArray, QImage> s_ramps(GRADIENT_RAMP_CACHE_SIZE);
+
+    auto key = gradientRampKey(stops);
+    QMutexLocker lock(&s_rampMutex);
+    if (auto ramp = s_ramps.object(key)) return *ramp;
+
+    auto sorted = stops;
+    std::stable_sort(sorted.begin(), sorted.end(), [](auto& a, auto& b) { return a.first < b.first; });
+
+    auto toPremultiplied = [](const QColor& c) {
+        auto a = float(c.alphaF());
+        return std::array<float, 4> { float(c.redF()) * a, float(c.greenF()) * a, float(c.blueF()) * a, a };
+    };
+
+    QImage ramp(GRADIENT_RAMP_SIZE, 1, QImage::Format_RGBA8888_Premultiplied);
+    auto p = ramp.bits();
+    int k = 0;
+
+    for (int i = 0; i < GRADIENT_RAMP_SIZE; ++i) {
+        auto t = float(i) / (GRADIENT_RAMP_SIZE - 1);
+        while (k < sorted.size() && sorted[k].first < t) k++;
+
+        std::array<float, 4> c;
+        if (k == 0) {
+            c = toPremultiplied(sorted.first().second);
+        } else if (k == sorted.size()) {
+            c = toPremultiplied(sorted.last().second);
+        } else {
+            auto& s0 = sorted[k - 1];
+            auto& s1 = sorted[k];
+            auto c0 = toPremultiplied(s0.second);
+            auto c1 = toPremultiplied(s1.second);
+            auto span = float(s1.first - s0.first);
+            auto f = span > 0 ? (t - float(s0.first)) / span : 1.0f;
+            for (int j = 0; j < 4; ++j) {
+                c[j] = c0[j] + (c1[j] - c0[j]) * f;
+            }
+        }
+
+        for (int j = 0; j < 4; ++j) {
+            *p++ = uchar(qBound(0, qRound(c[j] * 255), 255));
+        }
+    }
+
+    s_ramps.insert(key, new QImage(ramp));
+    return ramp;
+}
+
+// gradient of just two stops at 0 and 1 can be done without ramp
+static bool isSimpleGradient(const QGradientStops& stops)
+{
+    return stops.size() == 2 && stops[0].first == 0 && stops[1].first == 1;
+}
+
 NanoBrush::NanoBrush()
     : NanoBrush(QColor(Qt::transparent))
 {
@@ -63,9 +144,19 @@ NanoBrush::NanoBrush(const NVGpaint& paint)
     *m_paint = paint;
 }
 
+NanoBrush::NanoBrush(const NVGpaint& paint, Ramp ramp, const QGradientStops& stops)
+    : NanoBrush(paint)
+{
+    // the colors come from the ramp, inner color is only for the opacity
+    m_paint->innerColor = m_paint->outerColor = nvgRGBAf(1, 1, 1, 1);
+    m_image = gradientRamp(stops);
+    m_ramp = ramp;
+}
+
 NanoBrush::NanoBrush(const NanoBrush& that) noexcept
     : m_paint(new NVGpaint)
     , m_image(that.m_image)
+    , m_ramp(that.m_ramp)
 {
     *m_paint = *that.m_paint;
 }
@@ -73,6 +164,7 @@ NanoBrush::NanoBrush(const NanoBrush& that) noexcept
 NanoBrush::NanoBrush(NanoBrush&& that) noexcept
     : m_paint(that.m_paint)
     , m_image(that.m_image)
+    , m_ramp(that.m_ramp)
 {
     that.m_paint = nullptr;
 }
@@ -100,6 +192,75 @@ NanoBrush NanoBrush::radialGradient(const QColor& innerColor, const QColor& oute
             toNVGcolor(innerColor), toNVGcolor(outerColor)));
 }
 
+NanoBrush NanoBrush::linearGradient(const QGradientStops& stops, const QPointF& start, const QPointF& end)
+{
+    if (stops.isEmpty()) return NanoBrush();
+    if (stops.size() == 1) return NanoBrush(stops[0].second);
+    if (isSimpleGradient(stops)) return linearGradient(stops[0].second, stops[1].second, start, end);
+
+    return NanoBrush(nvgLinearGradient(nullptr, float(start.x()), float(start.y()), float(end.x()), float(end.y()), {}, {}),
+            Ramp::Box, stops);
+}
+
+NanoBrush NanoBrush::boxGradient(const QGradientStops& stops, const QRectF& box, qreal cornerRadius, qreal feather)
+{
+    if (stops.isEmpty()) return NanoBrush();
+    if (stops.size() == 1) return NanoBrush(stops[0].second);
+    if (isSimpleGradient(stops)) return boxGradient(stops[0].second, stops[1].second, box, cornerRadius, feather);
+
+    return NanoBrush(nvgBoxGradient(nullptr, float(box.x()), float(box.y()), float(box.width()), float(box.height()),
+            float(cornerRadius), float(feather), {}, {}), Ramp::Box, stops);
+}
+
+NanoBrush NanoBrush::radialGradient(const QGradientStops& stops, const QPointF& center, qreal innerRadius, qreal outerRadius)
+{
+    if (stops.isEmpty()) return NanoBrush();
+    if (stops.size() == 1) return NanoBrush(stops[0].second);
+    if (isSimpleGradient(stops)) return radialGradient(stops[0].second, stops[1].second, center, innerRadius, outerRadius);
+
+    return NanoBrush(nvgRadialGradient(nullptr, float(center.x()), float(center.y()), float(innerRadius), float(outerRadius), {}, {}),
+            Ramp::Box, stops);
+}
+
+NanoBrush NanoBrush::focalGradient(const QGradientStops& stops, const QPointF& center, qreal radius, const QPointF& focalPoint)
+{
+    if (stops.isEmpty()) return NanoBrush();
+    if (stops.size() == 1) return NanoBrush(stops[0].second);
+
+    // the paint space is centered at the center, extent is the focal point
+    NVGpaint p;
+    memset(&p, 0, sizeof(p));
+    nvgTransformIdentity(p.xform);
+    p.xform[4] = float(center.x());
+    p.xform[5] = float(center.y());
+    p.radius = float(qMax(radius, 0.0001));
+
+    auto focal = focalPoint - center;
+    auto d = qSqrt(QPointF::dotProduct(focal, focal));
+    auto limit = p.radius * 0.999;
+    if (d > limit) focal *= limit / d;
+    p.extent[0] = float(focal.x());
+    p.extent[1] = float(focal.y());
+
+    return NanoBrush(p, Ramp::Focal, stops);
+}
+
+NanoBrush NanoBrush::conicalGradient(const QGradientStops& stops, const QPointF& center, qreal angle)
+{
+    if (stops.isEmpty()) return NanoBrush();
+    if (stops.size() == 1) return NanoBrush(stops[0].second);
+
+    // the paint space is centered at the center, and rotated so the start angle is at +x
+    NVGpaint p;
+    memset(&p, 0, sizeof(p));
+    nvgTransformRotate(p.xform, -nvgDegToRad(float(angle)));
+    p.xform[4] = float(center.x());
+    p.xform[5] = float(center.y());
+    p.feather = 1.0f;
+
+    return NanoBrush(p, Ramp::Conical, stops);
+}
+
 NanoBrush NanoBrush::imagePattern(const QImage& image, const QRectF& rect, qreal rotation, qreal opacity)
 {
     auto part = rect;
@@ -116,13 +277,14 @@ NanoBrush NanoBrush::imagePattern(const QImage& image, const QRectF& rect, qreal
 bool NanoBrush::operator==(const NanoBrush& that) const
 {
     if (this == &that) return true;
-    return m_image == that.m_image && memcmp(m_paint, that.m_paint, sizeof(*m_paint)) == 0;
+    return m_ramp == that.m_ramp && m_image == that.m_image && memcmp(m_paint, that.m_paint, sizeof(*m_paint)) == 0;
 }
 
 NanoBrush& NanoBrush::operator=(const NanoBrush& that) noexcept
 {
     if (this == &that) return *this;
     m_image = that.m_image;
+    m_ramp = that.m_ramp;
     *m_paint = *that.m_paint;
     return *this;
 }
@@ -131,5 +293,6 @@ NanoBrush& NanoBrush::operator=(NanoBrush&& that) noexcept
 {
     qSwap(m_image, that.m_image);
     qSwap(m_paint, that.m_paint);
+    qSwap(m_ramp, that.m_ramp);
     return *this;
 }
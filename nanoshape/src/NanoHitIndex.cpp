@@ -0,0 +1,277 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#include "NanoHitIndex.h"
+#include "nanovg.h"
+
+#include <private/qtriangulator_p.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//---------------------------------------------------------------------------
+
+static const int MAX_GRID_SIZE = 256;
+
+// twice of the signed area
+static inline float cross(float ax, float ay, float bx, float by, float cx, float cy)
+{
+    return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+void NanoHitIndex::clear()
+{
+    m_triangles.clear();
+    m_paths.clear();
+    m_cellStart.clear();
+    m_cellItems.clear();
+    m_built = false;
+}
+
+int NanoHitIndex::pathIndex(const QString& name)
+{
+    // consecutive calls usually belong to the same path, e.g. fill then stroke
+    if (m_paths.isEmpty() || m_paths.constLast() != name) {
+        m_paths += name;
+    }
+    return m_paths.size() - 1;
+}
+
+void NanoHitIndex::addTriangle(int path, float x0, float y0, float x1, float y1, float x2, float y2)
+{
+    // the degenerate triangles are used to join strips, they never contain anything
+    if (cross(x0, y0, x1, y1, x2, y2) == 0) return;
+    m_triangles.push_back({ { x0, x1, x2 }, { y0, y1, y2 }, path });
+    m_built = false;
+}
+
+void NanoHitIndex::append(const NanoHitIndex& other)
+{
+    std::vector<int> paths(other.m_paths.size());
+    for (int i = 0; i < other.m_paths.size(); ++i) {
+        paths[i] = pathIndex(other.m_paths.at(i));
+    }
+
+    m_triangles.reserve(m_triangles.size() + other.m_triangles.size());
+    for (auto t : other.m_triangles) {
+        t.path = paths[t.path];
+        m_triangles.push_back(t);
+    }
+    m_built = false;
+}
+
+void NanoHitIndex::addTriangleStrip(const QString& name, const NVGvertex* verts, int count)
+{
+    if (count < 3) return;
+    auto path = pathIndex(name);
+    for (int i = 2; i < count; ++i) {
+        addTriangle(path, verts[i - 2].x, verts[i - 2].y, verts[i - 1].x, verts[i - 1].y, verts[i].x, verts[i].y);
+    }
+}
+
+void NanoHitIndex::addTriangleFan(const QString& name, const NVGvertex* verts, int count)
+{
+    if (count < 3) return;
+    auto path = pathIndex(name);
+    for (int i = 2; i < count; ++i) {
+        addTriangle(path, verts[0].x, verts[0].y, verts[i - 1].x, verts[i - 1].y, verts[i].x, verts[i].y);
+    }
+}
+
+void NanoHitIndex::addTriangles(const QString& name, const QTriangleSet& tri)
+{
+    auto count = tri.indices.size();
+    if (count < 3) return;
+
+    auto path = pathIndex(name);
+    auto indexData = static_cast<const quint32*>(tri.indices.data());
+    auto& v = tri.vertices;
+
+    for (int i = 0; i + 2 < count; i += 3) {
+        auto a = int(indexData[i]) * 2;
+        auto b = int(indexData[i + 1]) * 2;
+        auto c = int(indexData[i + 2]) * 2;
+        addTriangle(path, float(v.at(a)), float(v.at(a + 1)), float(v.at(b)), float(v.at(b + 1)), float(v.at(c)), float(v.at(c + 1)));
+    }
+}
+
+void NanoHitIndex::cellRange(float minX, float minY, float maxX, float maxY, int* range) const
+{
+    range[0] = std::clamp(int((minX - m_bounds[0]) / m_cellSize[0]), 0, m_columns - 1);
+    range[1] = std::clamp(int((minY - m_bounds[1]) / m_cellSize[1]), 0, m_rows - 1);
+    range[2] = std::clamp(int((maxX - m_bounds[0]) / m_cellSize[0]), 0, m_columns - 1);
+    range[3] = std::clamp(int((maxY - m_bounds[1]) / m_cellSize[1]), 0, m_rows - 1);
+}
+
+void NanoHitIndex::build() const
+{
+    if (m_built) return;
+    m_built = true;
+
+    m_cellStart.clear();
+    m_cellItems.clear();
+    if (m_triangles.empty()) return;
+
+    m_bounds[0] = m_bounds[1] = std::numeric_limits<float>::max();
+    m_bounds[2] = m_bounds[3] = std::numeric_limits<float>::lowest();
+    for (auto& t : m_triangles) {
+        m_bounds[0] = std::min({ m_bounds[0], t.x[0], t.x[1], t.x[2] });
+        m_bounds[1] = std::min({ m_bounds[1], t.y[0], t.y[1], t.y[2] });
+        m_bounds[2] = std::max({ m_bounds[2], t.x[0], t.x[1], t.x[2] });
+        m_bounds[3] = std::max({ m_bounds[3], t.y[0], t.y[1], t.y[2] });
+    }
+
+    // about 2 triangles per cell, square cells if possible
+    auto w = std::max(m_bounds[2] - m_bounds[0], 1.0f);
+    auto h = std::max(m_bounds[3] - m_bounds[1], 1.0f);
+    auto side = std::sqrt(w * h * 2 / float(m_triangles.size()));
+    m_columns = std::clamp(int(std::ceil(w / side)), 1, MAX_GRID_SIZE);
+    m_rows = std::clamp(int(std::ceil(h / side)), 1, MAX_GRID_SIZE);
+    m_cellSize[0] = w / float(m_columns);
+    m_cellSize[1] = h / float(m_rows);
+
+    // count, then fill, so each cell lists its triangles in paint order
+    m_cellStart.assign(m_columns * m_rows + 1, 0);
+    int range[4];
+
+    for (auto& t : m_triangles) {
+        cellRange(std::min({ t.x[0], t.x[1], t.x[2] }), std::min({ t.y[0], t.y[1], t.y[2] }),
+                std::max({ t.x[0], t.x[1], t.x[2] }), std::max({ t.y[0], t.y[1], t.y[2] }), range);
+        for (int row = range[1]; row <= range[3]; ++row) {
+            for (int col = range[0]; col <= range[2]; ++col) {
+                m_cellStart[row * m_columns + col + 1]++;
+            }
+        }
+    }
+
+    for (size_t i = 1; i < m_cellStart.size(); ++i) {
+        m_cellStart[i] += m_cellStart[i - 1];
+    }
+
+    m_cellItems.resize(m_cellStart.back());
+    std::vector<int> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+
+    for (int i = 0, n = int(m_triangles.size()); i < n; ++i) {
+        auto& t = m_triangles[i];
+        cellRange(std::min({ t.x[0], t.x[1], t.x[2] }), std::min({ t.y[0], t.y[1], t.y[2] }),
+                std::max({ t.x[0], t.x[1], t.x[2] }), std::max({ t.y[0], t.y[1], t.y[2] }), range);
+        for (int row = range[1]; row <= range[3]; ++row) {
+            for (int col = range[0]; col <= range[2]; ++col) {
+                m_cellItems[fill[row * m_columns + col]++] = i;
+            }
+        }
+    }
+}
+
+QString NanoHitIndex::pathAt(const QPointF& point) const
+{
+    build();
+    if (m_cellItems.empty()) return {};
+
+    auto x = float(point.x());
+    auto y = float(point.y());
+    if (x < m_bounds[0] || y < m_bounds[1] || x > m_bounds[2] || y > m_bounds[3]) return {};
+
+    int range[4];
+    cellRange(x, y, x, y, range);
+    auto cell = range[1] * m_columns + range[0];
+
+    // the last painted triangle is on top
+    for (int i = m_cellStart[cell + 1] - 1; i >= m_cellStart[cell]; --i) {
+        auto& t = m_triangles[m_cellItems[i]];
+        auto d0 = cross(t.x[0], t.y[0], t.x[1], t.y[1], x, y);
+        auto d1 = cross(t.x[1], t.y[1], t.x[2], t.y[2], x, y);
+        auto d2 = cross(t.x[2], t.y[2], t.x[0], t.y[0], x, y);
+        auto hasNeg = d0 < 0 || d1 < 0 || d2 < 0;
+        auto hasPos = d0 > 0 || d1 > 0 || d2 > 0;
+        if (!(hasNeg && hasPos)) return m_paths.at(t.path);
+    }
+
+    return {};
+}
+
+// separating axis test between triangle and axis aligned rect
+static bool intersects(const float* tx, const float* ty, float minX, float minY, float maxX, float maxY)
+{
+    if (std::max({ tx[0], tx[1], tx[2] }) < minX || std::min({ tx[0], tx[1], tx[2] }) > maxX) return false;
+    if (std::max({ ty[0], ty[1], ty[2] }) < minY || std::min({ ty[0], ty[1], ty[2] }) > maxY) return false;
+
+    float rx[4] = { minX, maxX, maxX, minX };
+    float ry[4] = { minY, minY, maxY, maxY };
+
+    for (int e = 0; e < 3; ++e) {
+        auto ax = tx[e];
+        auto ay = ty[e];
+        auto bx = tx[(e + 1) % 3];
+        auto by = ty[(e + 1) % 3];
+        auto side = cross(ax, ay, bx, by, tx[(e + 2) % 3], ty[(e + 2) % 3]);
+
+        // the rect is separated if all of its corners are on the other side of the edge
+        bool separated = true;
+        for (int i = 0; i < 4 && separated; ++i) {
+            auto d = cross(ax, ay, bx, by, rx[i], ry[i]);
+            separated = side > 0 ? d < 0 : d > 0;
+        }
+        if (separated) return false;
+    }
+
+    return true;
+}
+
+QStringList NanoHitIndex::pathsIn(const QRectF& rect) const
+{
+    build();
+    if (m_cellItems.empty() || rect.isEmpty()) return {};
+
+    auto r = rect.normalized();
+    auto minX = float(r.left());
+    auto minY = float(r.top());
+    auto maxX = float(r.right());
+    auto maxY = float(r.bottom());
+    if (maxX < m_bounds[0] || maxY < m_bounds[1] || minX > m_bounds[2] || minY > m_bounds[3]) return {};
+
+    std::vector<bool> hit(m_paths.size());
+    int range[4];
+    cellRange(minX, minY, maxX, maxY, range);
+
+    for (int row = range[1]; row <= range[3]; ++row) {
+        for (int col = range[0]; col <= range[2]; ++col) {
+            auto cell = row * m_columns + col;
+            for (int i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i) {
+                auto& t = m_triangles[m_cellItems[i]];
+                if (hit[t.path]) continue;
+                if (intersects(t.x, t.y, minX, minY, maxX, maxY)) hit[t.path] = true;
+            }
+        }
+    }
+
+    QStringList names;
+    for (int i = 0, n = int(hit.size()); i < n; ++i) {
+        if (hit[i] && !names.contains(m_paths.at(i))) names += m_paths.at(i);
+    }
+    return names;
+}
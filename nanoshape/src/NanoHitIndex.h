@@ -0,0 +1,86 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+
+#include <QPointF>
+#include <QRectF>
+#include <QStringList>
+
+#include <vector>
+
+class QTriangleSet;
+struct NVGvertex;
+
+//---------------------------------------------------------------------------
+
+// the tessellated triangles of the named paths, in paint order.
+// the uniform grid is built on the first query, so recording is cheap.
+class NanoHitIndex
+{
+public:
+    void clear();
+    bool isEmpty() const { return m_triangles.empty(); }
+
+    void addTriangleStrip(const QString& name, const NVGvertex* verts, int count);
+    void addTriangleFan(const QString& name, const NVGvertex* verts, int count);
+    void addTriangles(const QString& name, const QTriangleSet& tri);
+
+    // add the triangles of the other index, as if they were painted after this one
+    void append(const NanoHitIndex& other);
+
+    // the topmost path that contains the point, or empty string if none
+    QString pathAt(const QPointF& point) const;
+
+    // all the paths that intersect the rect, in paint order
+    QStringList pathsIn(const QRectF& rect) const;
+
+private:
+    struct Triangle
+    {
+        float x[3];
+        float y[3];
+        int path;
+    };
+
+    int pathIndex(const QString& name);
+    void addTriangle(int path, float x0, float y0, float x1, float y1, float x2, float y2);
+    void build() const;
+    void cellRange(float minX, float minY, float maxX, float maxY, int* range) const;
+
+private:
+    std::vector<Triangle> m_triangles;
+    QStringList m_paths;
+
+    // the grid cells are stored as offsets into the triangle index list
+    mutable bool m_built = false;
+    mutable float m_bounds[4] = {};
+    mutable float m_cellSize[2] = {};
+    mutable int m_columns = 0;
+    mutable int m_rows = 0;
+    mutable std::vector<int> m_cellStart;
+    mutable std::vector<int> m_cellItems;
+};
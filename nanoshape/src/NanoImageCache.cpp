@@ -0,0 +1,212 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#include "NanoImageCache.h"
+
+#include <QQmlEngine>
+#include <QQuickImageProvider>
+#include <QThreadPool>
+
+//---------------------------------------------------------------------------
+
+static constexpr int DEFAULT_CACHE_LIMIT = 64 * 1024 * 1024;
+
+// QCache cost is int, so cost is counted in KB to allow large budget
+static inline int imageCost(const QImage& image)
+{
+    return int(qMax<qint64>(1, qint64(image.sizeInBytes()) / 1024));
+}
+
+static QString toImagePath(const QUrl& url)
+{
+    if (url.isLocalFile()) return url.toLocalFile();
+    if (url.scheme() != QLatin1String("qrc")) return {};
+
+    auto path = url.path();
+    if (path.startsWith('/')) return ':' + path;
+    return QLatin1String(":/") + path;
+}
+
+static QImage toCachedImage(const QImage& image)
+{
+    // convert on the loader thread, so texture upload does not need to do it again
+    if (image.isNull()) return image;
+    return image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+NanoImageCache* NanoImageCache::instance()
+{
+    static NanoImageCache s_instance;
+    return &s_instance;
+}
+
+NanoImageCache::NanoImageCache()
+{
+    m_cache.setMaxCost(DEFAULT_CACHE_LIMIT / 1024);
+}
+
+int NanoImageCache::cacheLimit() const
+{
+    QMutexLocker lock(&m_mutex);
+    return int(qMin<qint64>(qint64(m_cache.maxCost()) * 1024, INT_MAX));
+}
+
+void NanoImageCache::setCacheLimit(int bytes)
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.setMaxCost(qMax(0, bytes / 1024));
+}
+
+void NanoImageCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.clear();
+}
+
+QImage NanoImageCache::image(const QUrl& url, QQmlEngine* engine, bool* pending)
+{
+    auto key = url.toString();
+    if (pending) *pending = false;
+
+    {
+        QMutexLocker lock(&m_mutex);
+        if (auto image = m_cache.object(key)) return *image;
+        if (m_pending.contains(key)) {
+            if (pending) *pending = true;
+            return {};
+        }
+        m_pending.insert(key);
+    }
+
+    load(key, url, engine);
+
+    QMutexLocker lock(&m_mutex);
+    if (auto image = m_cache.object(key)) return *image;
+    if (pending) *pending = m_pending.contains(key);
+    return {};
+}
+
+void NanoImageCache::load(const QString& key, const QUrl& url, QQmlEngine* engine)
+{
+    if (url.scheme() == QLatin1String("image")) {
+        loadFromProvider(key, url, engine);
+        return;
+    }
+
+    auto path = toImagePath(url);
+    if (path.isEmpty()) {
+        qWarning("NanoImageCache: unsupported image url %s", qPrintable(key));
+        finish(key, {});
+        return;
+    }
+
+    QThreadPool::globalInstance()->start([this, key, path] {
+        finish(key, toCachedImage(QImage(path)));
+    });
+}
+
+void NanoImageCache::loadFromProvider(const QString& key, const QUrl& url, QQmlEngine* engine)
+{
+    auto provider = engine ? engine->imageProvider(url.host()) : nullptr;
+    if (!provider) {
+        qWarning("NanoImageCache: no image provider for %s", qPrintable(key));
+        finish(key, {});
+        return;
+    }
+
+    // same as QQuickPixmap, the id is everything after "image://<provider>/"
+    auto id = url.toString(QUrl::RemoveScheme | QUrl::RemoveAuthority).mid(1);
+
+    switch (provider->imageType()) {
+    case QQmlImageProviderBase::Image: {
+        auto imageProvider = static_cast<QQuickImageProvider*>(provider);
+        if (imageProvider->flags() & QQmlImageProviderBase::ForceAsynchronousImageLoading) {
+            QThreadPool::globalInstance()->start([this, key, id, imageProvider] {
+                QSize size;
+                finish(key, toCachedImage(imageProvider->requestImage(id, &size, {})));
+            });
+        } else {
+            QSize size;
+            finish(key, toCachedImage(imageProvider->requestImage(id, &size, {})));
+        }
+        break;
+    }
+    case QQmlImageProviderBase::Pixmap: {
+        // QPixmap can only be used in GUI thread
+        QSize size;
+        auto pixmap = static_cast<QQuickImageProvider*>(provider)->requestPixmap(id, &size, {});
+        finish(key, toCachedImage(pixmap.toImage()));
+        break;
+    }
+    case QQmlImageProviderBase::Texture: {
+        QSize size;
+        auto factory = static_cast<QQuickImageProvider*>(provider)->requestTexture(id, &size, {});
+        finish(key, factory ? toCachedImage(factory->image()) : QImage());
+        delete factory;
+        break;
+    }
+    case QQmlImageProviderBase::ImageResponse: {
+        auto response = static_cast<QQuickAsyncImageProvider*>(provider)->requestImageResponse(id, {});
+        if (!response) {
+            finish(key, {});
+            break;
+        }
+        connect(response, &QQuickImageResponse::finished, this, [this, key, response] {
+            QImage image;
+            if (response->errorString().isEmpty()) {
+                auto factory = response->textureFactory();
+                if (factory) image = toCachedImage(factory->image());
+                delete factory;
+            }
+            response->deleteLater();
+            finish(key, image);
+        }, Qt::QueuedConnection);
+        break;
+    }
+    default:
+        qWarning("NanoImageCache: unsupported image provider for %s", qPrintable(key));
+        finish(key, {});
+        break;
+    }
+}
+
+void NanoImageCache::finish(const QString& key, QImage image)
+{
+    if (image.isNull()) qWarning("NanoImageCache: failed to load image %s", qPrintable(key));
+
+    {
+        QMutexLocker lock(&m_mutex);
+        m_pending.remove(key);
+
+        // failed image is also cached (as null image), so it will not be loaded over and over again.
+        // image larger than the budget still stays until next insertion, otherwise it would be reloaded on every paint
+        auto cost = qMin(imageCost(image), m_cache.maxCost());
+        m_cache.insert(key, new QImage(std::move(image)), cost);
+    }
+
+    // this may be called from loader thread, receivers in GUI thread get it queued
+    emit imageReady(key);
+}
@@ -0,0 +1,73 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QUrl>
+
+class QQmlEngine;
+
+//---------------------------------------------------------------------------
+
+// process-wide cache of decoded images, keyed by url.
+// images are decoded on the global thread pool, imageReady() is emitted when done.
+class NanoImageCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static NanoImageCache* instance();
+
+    // return the cached image, or null image if it is not available (yet).
+    // pending is set to true if the image is still loading.
+    QImage image(const QUrl& url, QQmlEngine* engine, bool* pending = nullptr);
+
+    // memory budget in bytes
+    int cacheLimit() const;
+    void setCacheLimit(int bytes);
+
+    void clear();
+
+signals:
+    void imageReady(const QString& key);
+
+private:
+    NanoImageCache();
+
+    void load(const QString& key, const QUrl& url, QQmlEngine* engine);
+    void loadFromProvider(const QString& key, const QUrl& url, QQmlEngine* engine);
+    void finish(const QString& key, QImage image);
+
+private:
+    mutable QMutex m_mutex;
+    QCache<QString, QImage> m_cache;
+    QSet<QString> m_pending;
+};
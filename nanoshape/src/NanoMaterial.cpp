@@ -32,16 +32,55 @@
 
 //---------------------------------------------------------------------------
 
+// return true if the field is different from the field of old material (or there is no old material)
+template <typename T>
+static inline bool isFieldChanged(const T& field, const T* oldField)
+{
+    return !oldField || memcmp(&field, oldField, sizeof(T)) != 0;
+}
+
+//---------------------------------------------------------------------------
+
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 
+// std140 offsets of the fields in the uniform block of each variant, -1 if the variant does not use it
+struct NanoUniformLayout
+{
+    int paintMatrix;
+    int innerColor;
+    int outerColor;
+    int textureRect;
+    int extent;
+    int radius;
+    int feather;
+    int strokeMultiply;
+    int strokeThreshold;
+    int type;
+    int edgeAA;
+    int scissorMatrix;
+    int scissorExtent;
+    int scissorScale;
+};
+
+static const NanoUniformLayout s_uniformLayouts[NanoMaterial::VariantCount] = {
+    // paintMatrix, innerColor, outerColor, textureRect, extent, radius, feather, strokeMultiply, strokeThreshold, type, edgeAA, scissorMatrix, scissorExtent, scissorScale
+    { -1, 80, -1, -1, -1, -1, -1, -1, -1, -1, -1, 96, 144, 152 }, // VariantColor
+    { -1, 80, -1, -1, -1, -1, -1, 96, 100, -1, -1, 112, 160, 168 }, // VariantColorAA
+    { 80, 128, 144, 160, 176, 184, 188, 192, 196, 200, 204, 208, 256, 264 }, // VariantGradient
+    { 80, 128, -1, 144, 160, -1, -1, 168, 172, -1, 176, 192, 240, 248 }, // VariantImagePattern
+    { -1, 80, -1, -1, -1, -1, -1, 96, 100, -1, 104, 112, 160, 168 }, // VariantImagePatternBatched
+};
+
 class NanoMaterialShader : public QSGMaterialShader
 {
 public:
-    NanoMaterialShader()
+    explicit NanoMaterialShader(NanoMaterial::Variant variant)
     {
         setFlag(UpdatesGraphicsPipelineState);
-        setShaderFileName(VertexStage, QLatin1String(":/NanoShape/NanoShader.vert.qsb"));
-        setShaderFileName(FragmentStage, QLatin1String(":/NanoShape/NanoShader.frag.qsb"));
+        // only the batched image pattern has its own vertex shader, for the pattern attributes
+        auto vertexVariant = variant == NanoMaterial::VariantImagePatternBatched ? NanoMaterial::variantName(variant) : QLatin1String("");
+        setShaderFileName(VertexStage, QLatin1String(":/NanoShape/NanoShader%1.vert.qsb").arg(vertexVariant));
+        setShaderFileName(FragmentStage, QLatin1String(":/NanoShape/NanoShader%1.frag.qsb").arg(NanoMaterial::variantName(variant)));
     }
 
     virtual void initResource()
@@ -69,11 +108,31 @@ public:
             changed = true;
         }
 
-        if (!oldMaterial || m->info() != m0->info()) {
-            auto p = reinterpret_cast<NanoMaterial::UniformBuffer*>(buf.data() + 64 + 16);
-            *p = m->info();
+        // only the fields used by the variant are written, and only if they are changed
+        auto& layout = s_uniformLayouts[m->variant()];
+        auto& info = m->info();
+        auto old = m0 ? &m0->info() : nullptr;
+
+        auto update = [&](int offset, const auto& field, const auto* oldField) {
+            if (offset < 0 || !isFieldChanged(field, oldField)) return;
+            memcpy(buf.data() + offset, &field, sizeof(field));
             changed = true;
-        }
+        };
+
+        update(layout.paintMatrix, info.paintMatrix, old ? &old->paintMatrix : nullptr);
+        update(layout.innerColor, info.innerColor, old ? &old->innerColor : nullptr);
+        update(layout.outerColor, info.outerColor, old ? &old->outerColor : nullptr);
+        update(layout.textureRect, info.textureRect, old ? &old->textureRect : nullptr);
+        update(layout.extent, info.extent, old ? &old->extent : nullptr);
+        update(layout.radius, info.radius, old ? &old->radius : nullptr);
+        update(layout.feather, info.feather, old ? &old->feather : nullptr);
+        update(layout.strokeMultiply, info.strokeMultiply, old ? &old->strokeMultiply : nullptr);
+        update(layout.strokeThreshold, info.strokeThreshold, old ? &old->strokeThreshold : nullptr);
+        update(layout.type, info.type, old ? &old->type : nullptr);
+        update(layout.edgeAA, info.edgeAA, old ? &old->edgeAA : nullptr);
+        update(layout.scissorMatrix, info.scissorMatrix, old ? &old->scissorMatrix : nullptr);
+        update(layout.scissorExtent, info.scissorExtent, old ? &old->scissorExtent : nullptr);
+        update(layout.scissorScale, info.scissorScale, old ? &old->scissorScale : nullptr);
 
         return changed;
     }
@@ -158,10 +217,10 @@ public:
 class NanoMaterialShader : public QSGMaterialShader
 {
 public:
-    NanoMaterialShader()
+    explicit NanoMaterialShader(NanoMaterial::Variant variant)
     {
         setShaderSourceFile(QOpenGLShader::Vertex, QLatin1String(":/NanoShape/NanoShaderGLES.vert"));
-        setShaderSourceFile(QOpenGLShader::Fragment, QLatin1String(":/NanoShape/NanoShaderGLES.frag"));
+        setShaderSourceFile(QOpenGLShader::Fragment, QLatin1String(":/NanoShape/NanoShaderGLES%1.frag").arg(NanoMaterial::variantName(variant)));
     }
 
     virtual void initResource()
@@ -187,6 +246,10 @@ public:
         m_id_strokeThreshold = p->uniformLocation("strokeThreshold");
         m_id_type = p->uniformLocation("type");
         m_id_edgeAA = p->uniformLocation("edgeAA");
+        m_id_textureRect = p->uniformLocation("textureRect");
+        m_id_scissorMatrix = p->uniformLocation("scissorMatrix");
+        m_id_scissorExtent = p->uniformLocation("scissorExtent");
+        m_id_scissorScale = p->uniformLocation("scissorScale");
     }
 
     virtual void updateState(const RenderState& state, QSGMaterial* newMaterial, QSGMaterial* oldMaterial) override
@@ -204,24 +267,60 @@ public:
             p->setUniformValue(m_id_opacity, GLfloat(state.opacity()));
         }
 
-        if (!m0 || m->info() != m0->info()) {
-            auto& info = m->info();
+        // uniforms not used by the variant have location -1, and are skipped
+        auto& info = m->info();
+        auto old = m0 ? &m0->info() : nullptr;
+
+        if (m_id_paintMatrix >= 0 && isFieldChanged(info.paintMatrix, old ? &old->paintMatrix : nullptr)) {
             float paintMatrix[3 * 3];
             memcpy(&paintMatrix[0], &info.paintMatrix[0], 3 * sizeof(float));
             memcpy(&paintMatrix[3], &info.paintMatrix[4], 3 * sizeof(float));
             memcpy(&paintMatrix[6], &info.paintMatrix[8], 3 * sizeof(float));
-
             p->setUniformValueArray(m_id_paintMatrix, paintMatrix, 3, 3);
+        }
+        if (m_id_innerColor >= 0 && isFieldChanged(info.innerColor, old ? &old->innerColor : nullptr)) {
             p->setUniformValueArray(m_id_innerColor, info.innerColor, 1, 4);
+        }
+        if (m_id_outerColor >= 0 && isFieldChanged(info.outerColor, old ? &old->outerColor : nullptr)) {
             p->setUniformValueArray(m_id_outerColor, info.outerColor, 1, 4);
+        }
+        if (m_id_textureRect >= 0 && isFieldChanged(info.textureRect, old ? &old->textureRect : nullptr)) {
+            p->setUniformValueArray(m_id_textureRect, info.textureRect, 1, 4);
+        }
+        if (m_id_extent >= 0 && isFieldChanged(info.extent, old ? &old->extent : nullptr)) {
             p->setUniformValueArray(m_id_extent, info.extent, 1, 2);
+        }
+        if (m_id_radius >= 0 && isFieldChanged(info.radius, old ? &old->radius : nullptr)) {
             p->setUniformValue(m_id_radius, info.radius);
+        }
+        if (m_id_feather >= 0 && isFieldChanged(info.feather, old ? &old->feather : nullptr)) {
             p->setUniformValue(m_id_feather, info.feather);
+        }
+        if (m_id_strokeMultiply >= 0 && isFieldChanged(info.strokeMultiply, old ? &old->strokeMultiply : nullptr)) {
             p->setUniformValue(m_id_strokeMultiply, info.strokeMultiply);
+        }
+        if (m_id_strokeThreshold >= 0 && isFieldChanged(info.strokeThreshold, old ? &old->strokeThreshold : nullptr)) {
             p->setUniformValue(m_id_strokeThreshold, info.strokeThreshold);
+        }
+        if (m_id_type >= 0 && isFieldChanged(info.type, old ? &old->type : nullptr)) {
             p->setUniformValue(m_id_type, info.type);
+        }
+        if (m_id_edgeAA >= 0 && isFieldChanged(info.edgeAA, old ? &old->edgeAA : nullptr)) {
             p->setUniformValue(m_id_edgeAA, info.edgeAA);
         }
+        if (m_id_scissorMatrix >= 0 && isFieldChanged(info.scissorMatrix, old ? &old->scissorMatrix : nullptr)) {
+            float scissorMatrix[3 * 3];
+            memcpy(&scissorMatrix[0], &info.scissorMatrix[0], 3 * sizeof(float));
+            memcpy(&scissorMatrix[3], &info.scissorMatrix[4], 3 * sizeof(float));
+            memcpy(&scissorMatrix[6], &info.scissorMatrix[8], 3 * sizeof(float));
+            p->setUniformValueArray(m_id_scissorMatrix, scissorMatrix, 3, 3);
+        }
+        if (m_id_scissorExtent >= 0 && isFieldChanged(info.scissorExtent, old ? &old->scissorExtent : nullptr)) {
+            p->setUniformValueArray(m_id_scissorExtent, info.scissorExtent, 1, 2);
+        }
+        if (m_id_scissorScale >= 0 && isFieldChanged(info.scissorScale, old ? &old->scissorScale : nullptr)) {
+            p->setUniformValueArray(m_id_scissorScale, info.scissorScale, 1, 2);
+        }
 
         if (!m0 || m->compositeOperation() != m0->compositeOperation()) {
             switch (m->compositeOperation()) {
@@ -261,7 +360,9 @@ public:
             }
         }
 
-        if (m->texture()) {
+        // color variants do not sample the texture
+        auto textured = m->variant() == NanoMaterial::VariantGradient || m->variant() == NanoMaterial::VariantImagePattern;
+        if (textured && m->texture()) {
             f->glActiveTexture(GL_TEXTURE0);
             m->texture()->bind();
         }
@@ -296,6 +397,10 @@ private:
     int m_id_strokeThreshold;
     int m_id_type;
     int m_id_edgeAA;
+    int m_id_textureRect;
+    int m_id_scissorMatrix;
+    int m_id_scissorExtent;
+    int m_id_scissorScale;
 };
 
 #endif
@@ -305,6 +410,10 @@ private:
 NanoMaterial::UniformBuffer::UniformBuffer()
 {
     memset(this, 0, sizeof(*this));
+
+    // no scissor, the mask is always 1
+    scissorExtent[0] = scissorExtent[1] = 1;
+    scissorScale[0] = scissorScale[1] = 1;
 }
 
 bool NanoMaterial::UniformBuffer::operator==(const NanoMaterial::UniformBuffer& that) const
@@ -319,6 +428,7 @@ NanoMaterial::NanoMaterial()
 
 NanoMaterial::~NanoMaterial()
 {
+    releaseCachedTexture();
     if (m_textureOwned) delete m_texture;
 }
 
@@ -335,10 +445,105 @@ void NanoMaterial::setStrokeWidth(float width)
 void NanoMaterial::setInfo(const NanoMaterial::UniformBuffer& info)
 {
     m_info = info;
+    m_variant = variantOf(info);
 }
 
+NanoMaterial::Variant NanoMaterial::variantOf(const NanoMaterial::UniformBuffer& info)
+{
+    switch (info.type) {
+    case TypeGradient:
+    case TypeGradientRamp:
+    case TypeConicalGradient:
+    case TypeFocalGradient:
+        return VariantGradient;
+    case TypeImagePattern:
+        return VariantImagePattern;
+    case TypeImagePatternBatched:
+        return VariantImagePatternBatched;
+    default:
+        return info.edgeAA ? VariantColorAA : VariantColor;
+    }
+}
+
+QLatin1String NanoMaterial::variantName(NanoMaterial::Variant variant)
+{
+    switch (variant) {
+    case VariantColorAA:
+        return QLatin1String("ColorAA");
+    case VariantGradient:
+        return QLatin1String("Gradient");
+    case VariantImagePattern:
+        return QLatin1String("ImagePattern");
+    case VariantImagePatternBatched:
+        return QLatin1String("ImagePatternBatched");
+    default:
+        return QLatin1String("Color");
+    }
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+
+const QSGGeometry::AttributeSet& NanoMaterial::patternAttributes()
+{
+    static const QSGGeometry::Attribute attributes[] = {
+        QSGGeometry::Attribute::createWithAttributeType(0, 2, QSGGeometry::FloatType, QSGGeometry::PositionAttribute),
+        QSGGeometry::Attribute::createWithAttributeType(1, 2, QSGGeometry::FloatType, QSGGeometry::TexCoordAttribute),
+        QSGGeometry::Attribute::createWithAttributeType(2, 2, QSGGeometry::FloatType, QSGGeometry::TexCoord1Attribute),
+        QSGGeometry::Attribute::createWithAttributeType(3, 4, QSGGeometry::FloatType, QSGGeometry::TexCoord2Attribute),
+    };
+    static const QSGGeometry::AttributeSet set = { 4, int(sizeof(PatternVertex)), attributes };
+    return set;
+}
+
+void NanoMaterial::updatePatternVertices(PatternVertex* vertices, int count, const UniformBuffer& info)
+{
+    // same as the image pattern shader, but the position is in item coordinates even if the renderer merges the geometry
+    auto m = info.paintMatrix;
+    for (int i = 0; i < count; ++i) {
+        auto& v = vertices[i];
+        v.px = (m[0] * v.x + m[4] * v.y + m[8]) / info.extent[0];
+        v.py = (m[1] * v.x + m[5] * v.y + m[9]) / info.extent[1];
+        memcpy(v.textureRect, info.textureRect, sizeof(v.textureRect));
+    }
+}
+
+void NanoMaterial::toBatchedPattern(UniformBuffer& info)
+{
+    info.type = TypeImagePatternBatched;
+    memset(info.paintMatrix, 0, sizeof(info.paintMatrix));
+    memset(info.extent, 0, sizeof(info.extent));
+    memset(info.textureRect, 0, sizeof(info.textureRect));
+}
+
+void NanoMaterial::writeUniformBlock(char* block, NanoMaterial::Variant variant, const NanoMaterial::UniformBuffer& info)
+{
+    auto& layout = s_uniformLayouts[variant];
+    auto write = [&](int offset, const auto& field) {
+        if (offset >= 0) memcpy(block + offset, &field, sizeof(field));
+    };
+
+    write(layout.paintMatrix, info.paintMatrix);
+    write(layout.innerColor, info.innerColor);
+    write(layout.outerColor, info.outerColor);
+    write(layout.textureRect, info.textureRect);
+    write(layout.extent, info.extent);
+    write(layout.radius, info.radius);
+    write(layout.feather, info.feather);
+    write(layout.strokeMultiply, info.strokeMultiply);
+    write(layout.strokeThreshold, info.strokeThreshold);
+    write(layout.type, info.type);
+    write(layout.edgeAA, info.edgeAA);
+    write(layout.scissorMatrix, info.scissorMatrix);
+    write(layout.scissorExtent, info.scissorExtent);
+    write(layout.scissorScale, info.scissorScale);
+}
+
+#endif
+
 void NanoMaterial::setTexture(QSGTexture* texture, bool owned)
 {
+    releaseCachedTexture();
+
     if (m_texture == texture) {
         m_textureOwned = owned;
         return;
@@ -347,42 +552,27 @@ void NanoMaterial::setTexture(QSGTexture* texture, bool owned)
     if (m_textureOwned) delete m_texture;
     m_texture = texture;
     m_textureOwned = owned;
-    m_textureImage = {};
 }
 
-void NanoMaterial::setTextureImage(QQuickWindow* window, const QImage& image)
+void NanoMaterial::setTextureImage(QQuickWindow* window, const QImage& image, bool gradientRamp)
 {
-    if (m_texture && m_textureImage == image) return;
-
-    QSGTexture* texture = nullptr;
-    bool textureOwned = true;
-
-    if (!image.isNull()) {
-        texture = window->createTextureFromImage(image);
-    }
-
-    if (!texture) {
-        static QHash<QQuickWindow*, QPair<QSGTexture*, QMetaObject::Connection>> dummyTextures;
-        auto& [dummyTexture, dummyTextureConnection] = dummyTextures[window];
+    auto resources = NanoResourceManager::forWindow(window);
+    if (!resources) return;
+    if (m_texture && m_resources == resources && m_textureKey == image.cacheKey()) return;
 
-        if (!dummyTexture) {
-            QImage dummyImage(4, 4, QImage::Format_RGBA8888_Premultiplied);
-            dummyImage.fill(Qt::transparent);
+    // acquire before release, so the texture is not dropped if it is the same
+    auto texture = resources->acquireTexture(image, gradientRamp);
+    setTexture(texture, false);
 
-            dummyTexture = window->createTextureFromImage(dummyImage);
-            dummyTextureConnection = QQuickWindow::connect(window, &QQuickWindow::sceneGraphInvalidated, [window] {
-                auto [dummyTexture, dummyTextureConnection] = dummyTextures.take(window);
-                QQuickWindow::disconnect(dummyTextureConnection);
-                delete dummyTexture;
-            });
-        }
-
-        texture = dummyTexture;
-        textureOwned = false;
-    }
+    m_resources = resources;
+    m_textureKey = texture == resources->dummyTexture() ? 0 : image.cacheKey();
+}
 
-    setTexture(texture, textureOwned);
-    m_textureImage = image;
+void NanoMaterial::releaseCachedTexture()
+{
+    if (!m_resources) return;
+    m_resources->releaseTexture(m_textureKey);
+    m_resources.reset();
 }
 
 void NanoMaterial::setCompositeOperation(NanoPainter::Composite op)
@@ -392,32 +582,51 @@ void NanoMaterial::setCompositeOperation(NanoPainter::Composite op)
 
 QSGMaterialType* NanoMaterial::type() const
 {
-    static QSGMaterialType type;
-    return &type;
+    static QSGMaterialType types[VariantCount];
+    return &types[m_variant];
 }
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 
 QSGMaterialShader* NanoMaterial::createShader(QSGRendererInterface::RenderMode) const
 {
-    return new NanoMaterialShader;
+    return new NanoMaterialShader(m_variant);
 }
 
 #else
 
 QSGMaterialShader* NanoMaterial::createShader() const
 {
-    return new NanoMaterialShader;
+    return new NanoMaterialShader(m_variant);
 }
 
 #endif
 
+static inline qint64 textureComparisonKey(QSGTexture* texture)
+{
+    if (!texture) return 0;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return texture->comparisonKey();
+#else
+    return texture->textureId();
+#endif
+}
+
 int NanoMaterial::compare(const QSGMaterial* other) const
 {
     if (!other) return 1;
     auto that = static_cast<const NanoMaterial*>(other);
     if (this == that) return 0;
     if (m_composite != that->m_composite) return m_composite < that->m_composite ? -1 : 1;
-    if (m_texture != that->m_texture) return m_texture < that->m_texture ? -1 : 1;
-    return this < that ? -1 : 1;
+
+    // atlas textures share the same underlying texture, so compare that instead of the sub-texture.
+    // the batched image pattern has the sub-rect and pattern matrix in its vertices, so it compares equal
+    auto key = textureComparisonKey(m_texture);
+    auto thatKey = textureComparisonKey(that->m_texture);
+    if (key != thatKey) return key < thatKey ? -1 : 1;
+
+    // textures are shared by NanoResourceManager, so materials with the same state can be batched
+    auto r = memcmp(&m_info, &that->m_info, sizeof(m_info));
+    if (r != 0) return r < 0 ? -1 : 1;
+    return 0;
 }
@@ -27,7 +27,9 @@
 #pragma once
 
 #include "NanoPainter.h"
+#include "NanoResourceManager.h"
 
+#include <QSGGeometry>
 #include <QSGMaterial>
 
 class QQuickWindow;
@@ -44,8 +46,24 @@ public:
         TypeColor,
         TypeGradient,
         TypeImagePattern,
+        TypeGradientRamp,
+        TypeConicalGradient,
+        TypeFocalGradient,
+        TypeImagePatternBatched,
     };
 
+    // each variant has its own specialized shader
+    enum Variant
+    {
+        VariantColor,
+        VariantColorAA,
+        VariantGradient,
+        VariantImagePattern,
+        VariantImagePatternBatched,
+        VariantCount,
+    };
+
+    // all the paint parameters, each variant only uploads the fields used by its shader
     struct UniformBuffer
     {
         float paintMatrix[3 * 4];
@@ -58,6 +76,10 @@ public:
         float strokeThreshold;
         qint32 type;
         qint32 edgeAA;
+        float textureRect[4];
+        float scissorMatrix[3 * 4];
+        float scissorExtent[2];
+        float scissorScale[2];
 
         UniformBuffer();
         bool operator==(const UniformBuffer& that) const;
@@ -77,9 +99,40 @@ public:
     const UniformBuffer& info() const { return m_info; }
     void setInfo(const UniformBuffer& info);
 
+    Variant variant() const { return m_variant; }
+    static Variant variantOf(const UniformBuffer& info);
+    static QLatin1String variantName(Variant variant);
+
+    // color only paint does not sample the texture
+    static bool isTextured(const UniformBuffer& info) { return info.type != TypeColor; }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    // the vertex of batched image pattern, the pattern coordinate and the texture sub-rect are in the vertex,
+    // so the materials of different patterns in the same atlas are the same, and the renderer can batch them
+    struct PatternVertex
+    {
+        float x, y, u, v;
+        float px, py;
+        float textureRect[4];
+    };
+
+    static const QSGGeometry::AttributeSet& patternAttributes();
+
+    // fill the pattern coordinate and texture sub-rect of the image pattern into the vertices (position is already there),
+    // then the info is turned into TypeImagePatternBatched, without the fields that are moved into the vertices
+    static void updatePatternVertices(PatternVertex* vertices, int count, const UniformBuffer& info);
+    static void toBatchedPattern(UniformBuffer& info);
+#endif
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    // the std140 uniform block of the variant shader, qt_Matrix and qt_Opacity are not written
+    static constexpr int UniformBlockSize = 272;
+    static void writeUniformBlock(char* block, Variant variant, const UniformBuffer& info);
+#endif
+
     QSGTexture* texture() const { return m_texture; }
     void setTexture(QSGTexture* texture, bool owned = true);
-    void setTextureImage(QQuickWindow* window, const QImage& image);
+    void setTextureImage(QQuickWindow* window, const QImage& image, bool gradientRamp = false);
 
     NanoPainter::Composite compositeOperation() const { return m_composite; }
     void setCompositeOperation(NanoPainter::Composite op);
@@ -96,9 +149,14 @@ public:
 private:
     NanoPainter::Composite m_composite = NanoPainter::Composite::SourceOver;
     QSGTexture* m_texture = nullptr;
-    QImage m_textureImage;
+    QSharedPointer<NanoResourceManager> m_resources;
+    qint64 m_textureKey = 0;
     UniformBuffer m_info;
+    Variant m_variant = VariantColor;
     QString m_name;
     float m_strokeWidth = 0;
     bool m_textureOwned = false;
+
+private:
+    void releaseCachedTexture();
 };
@@ -25,19 +25,29 @@
 //
 
 #include "NanoPainter.h"
+#include "NanoHitIndex.h"
 #include "NanoMaterial.h"
+#include "NanoRenderNode.h"
 #include "nanovg.h"
 
+#include <QMutex>
 #include <QPainterPath>
 #include <QPolygonF>
 #include <QQuickItem>
 #include <QQuickWindow>
+#include <QRunnable>
 #include <QSGGeometryNode>
 #include <QSGTexture>
+#include <QSemaphore>
+#include <QThreadPool>
 #include <QtMath>
 
 #include <private/qtriangulator_p.h>
 
+#include <algorithm>
+#include <iterator>
+#include <memory>
+
 #ifndef NANOSHAPE_TRACE
 #define NANOSHAPE_TRACE 0
 #endif
@@ -106,7 +116,9 @@ struct NanoPainterCall
     QString name;
     NanoPainter::Composite composite = NanoPainter::Composite::SourceOver;
     NVGpaint paint;
+    NVGscissor scissor;
     QImage image;
+    NanoBrush::Ramp ramp = NanoBrush::Ramp::None;
     float fringe = 0;
     float strokeWidth = 0;
     float strokeThreshold = 0;
@@ -135,6 +147,207 @@ struct NanoPainterCall
     }
 };
 
+static bool isConvexFill(const NVGpath* paths, int npaths)
+{
+    for (int i = 0; i < npaths; ++i) {
+        auto& path = paths[i];
+        if (path.nfill <= 0) continue;
+        if (!path.convex || path.winding != NVG_CCW) return false;
+    }
+    return true;
+}
+
+// the non-convex fill is triangulated from the path commands, since nanovg relies on stencil for it
+static QTriangleSet triangulateCommands(NVGcontext* nvg)
+{
+    QPainterPath path;
+    QPainterPath p;
+    bool hole = false;
+
+    float* buf;
+    auto n = nvgInternalCommands(nvg, &buf);
+
+    for (int i = 0; i < n; ++i) {
+        auto cmd = int(buf[i]);
+        switch (cmd) {
+        case NVG_MOVETO:
+            if (!p.isEmpty()) {
+                if (hole) {
+                    path = path.subtracted(p);
+                } else {
+                    path.addPath(p);
+                }
+                p.clear();
+            }
+            hole = false;
+            p.moveTo(buf[i + 1], buf[i + 2]);
+            i += 2;
+            break;
+        case NVG_LINETO:
+            p.lineTo(buf[i + 1], buf[i + 2]);
+            i += 2;
+            break;
+        case NVG_BEZIERTO:
+            p.cubicTo(buf[i + 1], buf[i + 2], buf[i + 3], buf[i + 4], buf[i + 5], buf[i + 6]);
+            i += 6;
+            break;
+        case NVG_CLOSE:
+            p.closeSubpath();
+            break;
+        case NVG_WINDING:
+            hole = int(buf[i + 1]) == NVG_HOLE;
+            i++;
+            break;
+        }
+    }
+
+    if (!p.isEmpty()) {
+        if (hole) {
+            path = path.subtracted(p);
+        } else {
+            path.addPath(p);
+        }
+    }
+    return qTriangulate(path);
+}
+
+static void addHitTriangles(NanoHitIndex& index, const QString& name, const NVGpath* paths, int npaths, bool fill)
+{
+    // the stroke is expanded already, so the stroke width is accounted
+    for (int i = 0; i < npaths; ++i) {
+        auto& path = paths[i];
+        if (fill) {
+            index.addTriangleFan(name, path.fill, path.nfill);
+        } else {
+            index.addTriangleStrip(name, path.stroke, path.nstroke);
+        }
+    }
+}
+
+static NanoPainterCall& addCall(std::vector<NanoPainterCall>& calls, const QString& name, NanoPainter::Composite composite,
+    const NVGpaint& paint, const NVGscissor& scissor, const NanoBrush& brush, float fringe, float strokeWidth)
+{
+    auto& call = calls.emplace_back();
+    call.name = name;
+    call.composite = composite;
+    call.paint = paint;
+    call.scissor = scissor;
+    call.image = brush.image();
+    call.ramp = brush.ramp();
+    call.fringe = fringe;
+    call.strokeWidth = strokeWidth;
+    call.strokeThreshold = -1;
+    return call;
+}
+
+//---------------------------------------------------------------------------
+
+// fill or stroke call to be tessellated on the thread pool, with the snapshot of nanovg state and path
+struct NanoPainterJob
+{
+    QString pathName;
+    NanoPainter::Composite composite = NanoPainter::Composite::SourceOver;
+    NanoBrush brush;
+    bool stroke = false;
+    std::unique_ptr<NVGsnapshot, void (*)(NVGsnapshot*)> snapshot { nullptr, &nvgInternalDeleteSnapshot };
+};
+
+// the jobs tessellated in order on one thread, the batches are merged in the order they are submitted
+struct NanoPainterBatch
+{
+    std::vector<NanoPainterJob> jobs;
+    std::vector<NanoPainterCall> calls;
+    NanoHitIndex hitIndex;
+    NanoPainter::Statistics statistics;
+    NVGcontext* worker = nullptr;
+    const NanoPainterJob* job = nullptr;
+    bool edgeAntiAlias = false;
+    bool nvgAntiAlias = false;
+    bool hitTestEnabled = false;
+    float width = 0;
+    float height = 0;
+    float pixelRatio = 1;
+
+    static constexpr int MAX_JOBS = 64;
+};
+
+//---------------------------------------------------------------------------
+
+// geometry node that remembers the hash of its content, so unchanged node can be left untouched on repaint.
+// its geometry and material are borrowed from the window pool, and returned when the node is deleted.
+class NanoGeometryNode : public QSGGeometryNode
+{
+public:
+    NanoGeometryNode(const QSharedPointer<NanoResourceManager>& resources, int vertexCount, int indexCount,
+            const QSGGeometry::AttributeSet& attributes)
+        : m_resources(resources)
+    {
+        setFlags(QSGNode::OwnedByParent);
+        setGeometry(resources->takeGeometry(vertexCount, indexCount, attributes));
+        setMaterial(resources->takeMaterial());
+    }
+
+    virtual ~NanoGeometryNode()
+    {
+        m_resources->recycleGeometry(geometry());
+        m_resources->recycleMaterial(static_cast<NanoMaterial*>(material()));
+    }
+
+    // the geometry may have more room than used, the extra room is filled with degenerate triangles.
+    // the renderer uploads all of the room, so the headroom is only added when it grows, and dropped soon.
+    void reserve(int vertexCount, int indexCount, const QSGGeometry::AttributeSet& attributes)
+    {
+        auto geo = geometry();
+
+        // the vertex layout changes with the paint (e.g. color to image pattern), so take another geometry
+        if (geo->attributes() != attributes.attributes) {
+            m_resources->recycleGeometry(geo);
+            setGeometry(m_resources->takeGeometry(vertexCount, indexCount, attributes));
+            m_oversizedCount = 0;
+            return;
+        }
+
+        auto vertexCapacity = geo->vertexCount();
+        auto indexCapacity = geo->indexCount();
+
+        // geometry with or without index must stay that way, since the extra room can not be dropped
+        auto fits = vertexCount <= vertexCapacity && indexCount <= indexCapacity
+                && (indexCount > 0) == (indexCapacity > 0) && vertexCount > 0;
+        auto oversized = vertexCount * 2 < vertexCapacity || indexCount * 2 < indexCapacity;
+
+        m_oversizedCount = fits && oversized ? m_oversizedCount + 1 : 0;
+        if (fits && m_oversizedCount < SHRINK_AFTER_UPDATES) return;
+
+        m_oversizedCount = 0;
+        geo->allocate(capacityFor(vertexCount), indexCount > 0 ? capacityFor(indexCount) : 0);
+    }
+
+    // node that changes on every repaint uses dynamic buffer, so the renderer does not rebuild the static batch
+    void updateDataPattern()
+    {
+        m_changedCount = qMin(m_changedCount + 1, DYNAMIC_AFTER_UPDATES);
+        auto pattern = m_changedCount >= DYNAMIC_AFTER_UPDATES ? QSGGeometry::DynamicPattern : QSGGeometry::StaticPattern;
+        auto geo = geometry();
+        geo->setVertexDataPattern(pattern);
+        geo->setIndexDataPattern(pattern);
+    }
+
+    static int capacityFor(int count)
+    {
+        return count <= 0 ? 0 : qMax(count + count / 4, 16);
+    }
+
+    static constexpr int SHRINK_AFTER_UPDATES = 4;
+    static constexpr int DYNAMIC_AFTER_UPDATES = 3;
+
+    QSharedPointer<NanoResourceManager> m_resources;
+    size_t m_hash = 0;
+    int m_vertexCount = 0;
+    int m_indexCount = 0;
+    int m_oversizedCount = 0;
+    int m_changedCount = 0;
+};
+
 //---------------------------------------------------------------------------
 
 class NanoPainterPrivate
@@ -239,24 +452,53 @@ public:
         static_cast<NanoPainterPrivate*>(uptr)->onRenderFlush();
     }
 
-    static void renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState, NVGscissor*, float fringe, const float*, const NVGpath* paths, int npaths)
+    static void renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState, NVGscissor* scissor, float fringe, const float*, const NVGpath* paths, int npaths)
     {
 #if NANOSHAPE_TRACE
         qDebug().noquote() << "renderFill" << uptr << "fringe:" << fringe;
         dump(paint);
         dump(paths, npaths);
 #endif
-        static_cast<NanoPainterPrivate*>(uptr)->onRenderFill(paint, fringe, paths, npaths);
+        static_cast<NanoPainterPrivate*>(uptr)->onRenderFill(paint, scissor, fringe, paths, npaths);
     }
 
-    static void renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState, NVGscissor*, float fringe, float strokeWidth, const NVGpath* paths, int npaths)
+    static void renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState, NVGscissor* scissor, float fringe, float strokeWidth, const NVGpath* paths, int npaths)
     {
 #if NANOSHAPE_TRACE
         qDebug() << "renderStroke" << uptr << "fringe:" << fringe << "strokeWidth:" << strokeWidth;
         dump(paint);
         dump(paths, npaths);
 #endif
-        static_cast<NanoPainterPrivate*>(uptr)->onRenderStroke(paint, fringe, strokeWidth, paths, npaths);
+        static_cast<NanoPainterPrivate*>(uptr)->onRenderStroke(paint, scissor, fringe, strokeWidth, paths, npaths);
+    }
+
+    static void renderBatchFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState, NVGscissor* scissor, float fringe, const float*, const NVGpath* paths, int npaths)
+    {
+        if (npaths <= 0) return;
+        auto batch = static_cast<NanoPainterBatch*>(uptr);
+        auto job = batch->job;
+        auto hit = batch->hitTestEnabled && !job->pathName.isEmpty();
+        auto& call = addCall(batch->calls, job->pathName + QLatin1String("_fill"), job->composite, *paint, *scissor, job->brush, fringe, fringe);
+
+        if (isConvexFill(paths, npaths)) {
+            if (hit) addHitTriangles(batch->hitIndex, job->pathName, paths, npaths, true);
+            call.addFill(paths, npaths);
+        } else {
+            // the commands of the job are restored in the worker context
+            auto tri = triangulateCommands(batch->worker);
+            if (hit) batch->hitIndex.addTriangles(job->pathName, tri);
+            call.data.emplace_back(tri);
+        }
+        if (batch->edgeAntiAlias) call.addStroke(paths, npaths);
+    }
+
+    static void renderBatchStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState, NVGscissor* scissor, float fringe, float strokeWidth, const NVGpath* paths, int npaths)
+    {
+        if (npaths <= 0) return;
+        auto batch = static_cast<NanoPainterBatch*>(uptr);
+        auto job = batch->job;
+        if (batch->hitTestEnabled && !job->pathName.isEmpty()) addHitTriangles(batch->hitIndex, job->pathName, paths, npaths, false);
+        addCall(batch->calls, job->pathName + QLatin1String("_stroke"), job->composite, *paint, *scissor, job->brush, fringe, strokeWidth).addStroke(paths, npaths);
     }
 
     static void renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState, NVGscissor*, const NVGvertex* verts, int nverts, float fringe)
@@ -346,11 +588,13 @@ public:
     QQuickItem* m_item;
     QSGNode* m_node;
     float m_itemPixelRatio = 1;
+    float m_fixedPixelRatio = 0;
     bool m_deferred;
 
     QString m_pathName;
     QTransform m_transform;
     qreal m_miterLimit = 10;
+    qreal m_simplifyTolerance = 0;
     Qt::PenCapStyle m_capStyle = Qt::FlatCap;
     Qt::PenJoinStyle m_joinStyle = Qt::MiterJoin;
     qreal m_strokeWidth = 1;
@@ -364,11 +608,44 @@ public:
     bool m_dashArrayDirty = false;
 
     std::vector<NanoPainterCall> m_pendingCalls;
-    QSGGeometryNode* m_nextFreeNode = nullptr;
-    QList<QSGMaterial*> m_freeMaterials;
+    NanoGeometryNode* m_nextFreeNode = nullptr;
+    QSharedPointer<NanoResourceManager> m_resources;
+    bool m_renderNodeEnabled = false;
+    QRectF m_visibleRect;
+    NanoPainter::Statistics m_statistics;
+
+    // the batch being recorded, the batches submitted to the thread pool, and the idle worker contexts
+    bool m_parallelTessellationEnabled = false;
+    std::unique_ptr<NanoPainterBatch> m_batch;
+    std::vector<std::unique_ptr<NanoPainterBatch>> m_batches;
+    NanoPainter::Statistics m_batchStatistics;
+    QSemaphore m_batchesDone;
+    QMutex m_workersMutex;
+    std::vector<NVGcontext*> m_workers;
+
+    // the hit index being painted, and the one of the last update for query
+    bool m_hitTestEnabled = false;
+    NanoHitIndex m_hitIndex;
+    NanoHitIndex m_lastHitIndex;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    NanoRenderNode* m_renderNode = nullptr;
+#endif
+
+    // the material parameters of the current update, and the hash of them
+    struct UpdateParams
+    {
+        QString name;
+        NanoPainter::Composite composite = NanoPainter::Composite::SourceOver;
+        NanoMaterial::UniformBuffer info;
+        QImage image;
+        float strokeWidth = 0;
+        size_t hash = 0;
+    };
 
-    NanoMaterial* m_updateMaterial = nullptr;
-    bool m_updateMaterialTaken = false;
+    UpdateParams m_update;
+    std::vector<NVGvertex> m_updateVertexBuf;
+    std::vector<uint> m_updateIndexBuf;
 
     NanoPainterPrivate(QQuickItem* item, QSGNode* node, float itemPixelRatio, bool deferred);
     ~NanoPainterPrivate();
@@ -380,12 +657,23 @@ public:
     void beginUpdate(QSGNode* node);
     QSGNode* endUpdate(QSGNode* node);
 
-    void onRenderFill(NVGpaint* paint, float fringe, const NVGpath* paths, int npaths);
-    void onRenderFillConvex(NVGpaint* paint, float fringe, const NVGpath* paths, int npaths);
-    void onRenderStroke(NVGpaint* paint, float fringe, float strokeWidth, const NVGpath* paths, int npaths);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    void beginRenderNodeUpdate();
+#endif
+
+    void onRenderFill(NVGpaint* paint, NVGscissor* scissor, float fringe, const NVGpath* paths, int npaths);
+    void onRenderFillConvex(NVGpaint* paint, NVGscissor* scissor, float fringe, const NVGpath* paths, int npaths);
+    void onRenderStroke(NVGpaint* paint, NVGscissor* scissor, float fringe, float strokeWidth, const NVGpath* paths, int npaths);
     void onRenderFlush();
+    void updateHitIndex(const NVGpath* paths, int npaths, bool fill);
 
-    void beginUpdateVertexData(const QString& name, NanoPainter::Composite composite, const NVGpaint& paint, const QImage& image, float width, float fringe, float strokeThreshold);
+    void queueJob(bool stroke);
+    void submitBatch();
+    void runBatch(NanoPainterBatch* batch);
+    void finishBatches();
+    void discardBatches();
+
+    void beginUpdateVertexData(const QString& name, NanoPainter::Composite composite, const NVGpaint& paint, const NVGscissor& scissor, NanoBrush::Ramp ramp, const QImage& image, float width, float fringe, float strokeThreshold);
     void updateVertexDataForStroke(const NVGpath* paths, int npaths);
     void updateVertexDataForFill(const NVGpath* paths, int npaths);
     void updateVertexData(const QTriangleSet& tri);
@@ -417,22 +705,26 @@ NanoPainterPrivate::NanoPainterPrivate(QQuickItem* item, QSGNode* node, float it
     m_params.renderDelete = &NanoPainterPrivate::renderDelete;
 
     m_nvg = nvgCreateInternal(&m_params);
-    m_itemPixelRatio = itemPixelRatio;
-    nvgBeginFrame(m_nvg, float(item->width()), float(item->height()), this->itemPixelRatio());
+    m_fixedPixelRatio = itemPixelRatio;
+    m_itemPixelRatio = this->itemPixelRatio();
+    nvgBeginFrame(m_nvg, float(item->width()), float(item->height()), m_itemPixelRatio);
     beginUpdate(node);
 }
 
 NanoPainterPrivate::~NanoPainterPrivate()
 {
+    discardBatches();
+    for (auto worker : m_workers) {
+        nvgDeleteInternal(worker);
+    }
     nvgDeleteInternal(m_nvg);
 }
 
 float NanoPainterPrivate::itemPixelRatio()
 {
-    if (!qFuzzyIsNull(m_itemPixelRatio)) return m_itemPixelRatio;
+    if (!qFuzzyIsNull(m_fixedPixelRatio)) return m_fixedPixelRatio;
     if (!m_item || !m_item->window()) return 1;
-    m_itemPixelRatio = NanoPainter::itemPixelRatio(m_item);
-    return m_itemPixelRatio;
+    return NanoPainter::itemPixelRatio(m_item);
 }
 
 void NanoPainterPrivate::applyTransform()
@@ -443,12 +735,16 @@ void NanoPainterPrivate::applyTransform()
 
 void NanoPainterPrivate::reset(QSGNode* node, bool deferred)
 {
+    discardBatches();
     m_params.edgeAntiAlias = m_item->antialiasing();
-    nvgBeginFrame(m_nvg, float(m_item->width()), float(m_item->height()), itemPixelRatio());
+    m_itemPixelRatio = itemPixelRatio();
+    nvgBeginFrame(m_nvg, float(m_item->width()), float(m_item->height()), m_itemPixelRatio);
     beginPath();
 
     m_transform.reset();
     m_miterLimit = 10;
+    m_simplifyTolerance = 0;
+    nvgInternalSimplifyTolerance(m_nvg, 0);
     m_capStyle = Qt::FlatCap;
     m_joinStyle = Qt::MiterJoin;
     m_strokeWidth = 1;
@@ -457,6 +753,8 @@ void NanoPainterPrivate::reset(QSGNode* node, bool deferred)
     m_composite = NanoPainter::Composite::SourceOver;
 
     m_pendingCalls.clear();
+    m_hitIndex.clear();
+    m_batchStatistics = {};
     m_deferred = deferred;
 
     beginUpdate(node);
@@ -471,20 +769,14 @@ void NanoPainterPrivate::beginPath(const QString& name)
 void NanoPainterPrivate::beginUpdate(QSGNode* node)
 {
     m_node = node;
-    m_freeMaterials.clear();
-    m_nextFreeNode = nullptr;
-    if (!node) return;
 
-    auto geo = static_cast<QSGGeometryNode*>(node->firstChild());
-    m_nextFreeNode = geo;
+    // render node is not recycled as geometry node, it is removed at the end of update
+    auto first = node ? node->firstChild() : nullptr;
+    m_nextFreeNode = first && first->type() == QSGNode::GeometryNodeType ? static_cast<NanoGeometryNode*>(first) : nullptr;
 
-    while (geo) {
-        if (geo->flags() & QSGNode::OwnsMaterial) {
-            geo->setFlag(QSGNode::OwnsMaterial, false);
-            m_freeMaterials += geo->material();
-        }
-        geo = static_cast<QSGGeometryNode*>(geo->nextSibling());
-    }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    m_renderNode = nullptr;
+#endif
 }
 
 QSGNode* NanoPainterPrivate::endUpdate(QSGNode* node)
@@ -500,160 +792,139 @@ QSGNode* NanoPainterPrivate::endUpdate(QSGNode* node)
         beginUpdate(node);
     }
 
+    finishBatches();
+
     nvgEndFrame(m_nvg);
+    nvgInternalStats(m_nvg, &m_statistics.drawCalls, &m_statistics.triangles, &m_statistics.culledCalls);
+    m_statistics.drawCalls += m_batchStatistics.drawCalls;
+    m_statistics.triangles += m_batchStatistics.triangles;
+    m_statistics.culledCalls += m_batchStatistics.culledCalls;
+    std::swap(m_hitIndex, m_lastHitIndex);
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    // the render node must be emptied even if nothing is painted
+    if (m_renderNodeEnabled && m_node) beginRenderNodeUpdate();
+    if (m_renderNode) {
+        m_renderNode->endUpdate();
+        m_renderNode = nullptr;
+    }
+#endif
+
     node = m_node;
 
+    // the leftover nodes return their geometry and material to the pool
     while (m_nextFreeNode) {
-        auto next = static_cast<QSGGeometryNode*>(m_nextFreeNode->nextSibling());
+        auto next = static_cast<NanoGeometryNode*>(m_nextFreeNode->nextSibling());
         node->removeChildNode(m_nextFreeNode);
+        delete m_nextFreeNode;
         m_nextFreeNode = next;
     }
 
-    qDeleteAll(m_freeMaterials);
+    if (!m_renderNodeEnabled && node && node->firstChild() && node->firstChild()->type() == QSGNode::RenderNodeType) {
+        auto child = node->firstChild();
+        node->removeChildNode(child);
+        delete child;
+    }
+
+    m_resources.reset();
     reset(nullptr, true);
     return node;
 }
 
-void NanoPainterPrivate::onRenderFill(NVGpaint* paint, float fringe, const NVGpath* paths, int npaths)
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+
+void NanoPainterPrivate::beginRenderNodeUpdate()
 {
-    if (npaths <= 0) return;
+    if (m_renderNode) return;
+    if (!m_node) m_node = new QSGNode();
+    if (!m_resources) m_resources = NanoResourceManager::forWindow(m_item->window());
 
-    bool convex = true;
-    for (int i = 0; i < npaths; ++i) {
-        auto path = paths[i];
-        if (path.nfill <= 0) continue;
-        if (!path.convex || path.winding != NVG_CCW) convex = false;
+    auto first = m_node->firstChild();
+    if (first && first->type() == QSGNode::RenderNodeType) {
+        m_renderNode = static_cast<NanoRenderNode*>(first);
+    } else {
+        m_renderNode = new NanoRenderNode(m_item->window());
+        m_node->prependChildNode(m_renderNode);
     }
 
-    if (convex) {
-        onRenderFillConvex(paint, fringe, paths, npaths);
-        return;
+    // the render node replaces all the geometry nodes
+    while (auto child = m_renderNode->nextSibling()) {
+        m_node->removeChildNode(child);
+        delete child;
     }
 
-    auto name = m_pathName + QLatin1String("_fill");
-    QPainterPath path;
-    QPainterPath p;
-    bool hole = false;
+    m_nextFreeNode = nullptr;
+    m_renderNode->beginUpdate(m_resources);
+}
 
-    float* buf;
-    auto n = nvgInternalCommands(m_nvg, &buf);
+#endif
 
-    for (int i = 0; i < n; ++i) {
-        auto cmd = int(buf[i]);
-        switch (cmd) {
-        case NVG_MOVETO:
-            if (!p.isEmpty()) {
-                if (hole) {
-                    path = path.subtracted(p);
-                } else {
-                    path.addPath(p);
-                }
-                p.clear();
-            }
-            hole = false;
-            p.moveTo(buf[i + 1], buf[i + 2]);
-            i += 2;
-            break;
-        case NVG_LINETO:
-            p.lineTo(buf[i + 1], buf[i + 2]);
-            i += 2;
-            break;
-        case NVG_BEZIERTO:
-            p.cubicTo(buf[i + 1], buf[i + 2], buf[i + 3], buf[i + 4], buf[i + 5], buf[i + 6]);
-            i += 6;
-            break;
-        case NVG_CLOSE:
-            p.closeSubpath();
-            break;
-        case NVG_WINDING:
-            hole = int(buf[i + 1]) == NVG_HOLE;
-            i++;
-            break;
-        }
-    }
+void NanoPainterPrivate::onRenderFill(NVGpaint* paint, NVGscissor* scissor, float fringe, const NVGpath* paths, int npaths)
+{
+    if (npaths <= 0) return;
 
-    if (!p.isEmpty()) {
-        if (hole) {
-            path = path.subtracted(p);
-        } else {
-            path.addPath(p);
-        }
+    if (isConvexFill(paths, npaths)) {
+        onRenderFillConvex(paint, scissor, fringe, paths, npaths);
+        return;
     }
-    auto tri = qTriangulate(path);
+
+    auto name = m_pathName + QLatin1String("_fill");
+    auto tri = triangulateCommands(m_nvg);
+    if (m_hitTestEnabled && !m_pathName.isEmpty()) m_hitIndex.addTriangles(m_pathName, tri);
 
     if (!m_deferred) {
-        beginUpdateVertexData(name, m_composite, *paint, m_fillBrush.image(), fringe, fringe, -1);
+        beginUpdateVertexData(name, m_composite, *paint, *scissor, m_fillBrush.ramp(), m_fillBrush.image(), fringe, fringe, -1);
         updateVertexData(tri);
         if (m_params.edgeAntiAlias) updateVertexDataForStroke(paths, npaths);
         endUpdateVertexData();
         return;
     }
 
-    auto& call = m_pendingCalls.emplace_back();
-    call.name = name;
-    call.composite = m_composite;
-    call.paint = *paint;
-    call.image = m_fillBrush.image();
-    call.fringe = fringe;
-    call.strokeWidth = fringe;
-    call.strokeThreshold = -1;
+    auto& call = addCall(m_pendingCalls, name, m_composite, *paint, *scissor, m_fillBrush, fringe, fringe);
     call.data.emplace_back(tri);
     if (m_params.edgeAntiAlias) call.addStroke(paths, npaths);
 }
 
-void NanoPainterPrivate::onRenderFillConvex(NVGpaint* paint, float fringe, const NVGpath* paths, int npaths)
+void NanoPainterPrivate::onRenderFillConvex(NVGpaint* paint, NVGscissor* scissor, float fringe, const NVGpath* paths, int npaths)
 {
     if (npaths <= 0) return;
     auto name = m_pathName + QLatin1String("_fill");
+    updateHitIndex(paths, npaths, true);
 
     if (!m_deferred) {
-        beginUpdateVertexData(name, m_composite, *paint, m_fillBrush.image(), fringe, fringe, -1);
+        beginUpdateVertexData(name, m_composite, *paint, *scissor, m_fillBrush.ramp(), m_fillBrush.image(), fringe, fringe, -1);
         updateVertexDataForFill(paths, npaths);
         if (m_params.edgeAntiAlias) updateVertexDataForStroke(paths, npaths);
         endUpdateVertexData();
         return;
     }
 
-    auto& call = m_pendingCalls.emplace_back();
-    call.name = name;
-    call.composite = m_composite;
-    call.paint = *paint;
-    call.image = m_fillBrush.image();
-    call.fringe = fringe;
-    call.strokeWidth = fringe;
-    call.strokeThreshold = -1;
+    auto& call = addCall(m_pendingCalls, name, m_composite, *paint, *scissor, m_fillBrush, fringe, fringe);
     call.addFill(paths, npaths);
     if (m_params.edgeAntiAlias) call.addStroke(paths, npaths);
 }
 
-void NanoPainterPrivate::onRenderStroke(NVGpaint* paint, float fringe, float strokeWidth, const NVGpath* paths, int npaths)
+void NanoPainterPrivate::onRenderStroke(NVGpaint* paint, NVGscissor* scissor, float fringe, float strokeWidth, const NVGpath* paths, int npaths)
 {
     if (npaths <= 0) return;
     auto name = m_pathName + QLatin1String("_stroke");
+    updateHitIndex(paths, npaths, false);
 
     if (!m_deferred) {
-        beginUpdateVertexData(name, m_composite, *paint, m_strokeBrush.image(), fringe, strokeWidth, -1);
+        beginUpdateVertexData(name, m_composite, *paint, *scissor, m_strokeBrush.ramp(), m_strokeBrush.image(), fringe, strokeWidth, -1);
         updateVertexDataForStroke(paths, npaths);
         endUpdateVertexData();
         return;
     }
 
-    auto& call = m_pendingCalls.emplace_back();
-    call.name = name;
-    call.composite = m_composite;
-    call.paint = *paint;
-    call.image = m_strokeBrush.image();
-    call.fringe = fringe;
-    call.strokeWidth = strokeWidth;
-    call.strokeThreshold = -1;
-    call.addStroke(paths, npaths);
+    addCall(m_pendingCalls, name, m_composite, *paint, *scissor, m_strokeBrush, fringe, strokeWidth).addStroke(paths, npaths);
 }
 
 void NanoPainterPrivate::onRenderFlush()
 {
     for (auto& call : m_pendingCalls) {
         if (call.data.empty()) continue;
-        beginUpdateVertexData(call.name, call.composite, call.paint, call.image, call.fringe, call.strokeWidth, call.strokeThreshold);
+        beginUpdateVertexData(call.name, call.composite, call.paint, call.scissor, call.ramp, call.image, call.fringe, call.strokeWidth, call.strokeThreshold);
 
         for (auto& geo : call.data) {
             if (geo.mode == QSGGeometry::DrawTriangles) {
@@ -669,6 +940,138 @@ void NanoPainterPrivate::onRenderFlush()
     m_pendingCalls.clear();
 }
 
+void NanoPainterPrivate::updateHitIndex(const NVGpath* paths, int npaths, bool fill)
+{
+    if (!m_hitTestEnabled || m_pathName.isEmpty()) return;
+    addHitTriangles(m_hitIndex, m_pathName, paths, npaths, fill);
+}
+
+void NanoPainterPrivate::queueJob(bool stroke)
+{
+    if (!m_batch) {
+        m_batch = std::make_unique<NanoPainterBatch>();
+        m_batch->jobs.reserve(NanoPainterBatch::MAX_JOBS);
+        m_batch->edgeAntiAlias = m_params.edgeAntiAlias;
+        m_batch->nvgAntiAlias = nvgInternalParams(m_nvg)->edgeAntiAlias;
+        m_batch->hitTestEnabled = m_hitTestEnabled;
+        m_batch->width = float(m_item->width());
+        m_batch->height = float(m_item->height());
+        m_batch->pixelRatio = m_itemPixelRatio;
+    }
+
+    auto& job = m_batch->jobs.emplace_back();
+    job.pathName = m_pathName;
+    job.composite = m_composite;
+    job.brush = stroke ? m_strokeBrush : m_fillBrush;
+    job.stroke = stroke;
+    job.snapshot.reset(nvgInternalSnapshot(m_nvg));
+
+    if (int(m_batch->jobs.size()) >= NanoPainterBatch::MAX_JOBS) submitBatch();
+}
+
+void NanoPainterPrivate::submitBatch()
+{
+    if (!m_batch) return;
+    auto batch = m_batch.get();
+    m_batches.push_back(std::move(m_batch));
+
+    // the batches are started as soon as they are full, so they are tessellated while the rest is recorded
+    QThreadPool::globalInstance()->start(QRunnable::create([this, batch] {
+        runBatch(batch);
+        m_batchesDone.release();
+    }));
+}
+
+void NanoPainterPrivate::runBatch(NanoPainterBatch* batch)
+{
+    {
+        QMutexLocker lock(&m_workersMutex);
+        if (!m_workers.empty()) {
+            batch->worker = m_workers.back();
+            m_workers.pop_back();
+        }
+    }
+
+    if (!batch->worker) {
+        auto params = m_params;
+        params.renderFlush = &NanoPainterPrivate::renderCancel;
+        params.renderFill = &NanoPainterPrivate::renderBatchFill;
+        params.renderStroke = &NanoPainterPrivate::renderBatchStroke;
+        batch->worker = nvgCreateInternal(&params);
+    }
+
+    auto worker = batch->worker;
+    auto params = nvgInternalParams(worker);
+    params->userPtr = batch;
+    params->edgeAntiAlias = batch->nvgAntiAlias;
+    nvgBeginFrame(worker, batch->width, batch->height, batch->pixelRatio);
+
+    for (auto& job : batch->jobs) {
+        if (!job.snapshot) continue;
+        batch->job = &job;
+        nvgInternalRestore(worker, job.snapshot.get());
+        if (job.stroke) {
+            nvgStroke(worker);
+        } else {
+            nvgFill(worker);
+        }
+    }
+
+    auto& stats = batch->statistics;
+    nvgInternalStats(worker, &stats.drawCalls, &stats.triangles, &stats.culledCalls);
+
+    // the worker must not refer to the snapshot or batch once it is idle
+    nvgBeginPath(worker);
+    params->userPtr = this;
+    batch->worker = nullptr;
+    batch->job = nullptr;
+    batch->jobs.clear();
+
+    QMutexLocker lock(&m_workersMutex);
+    m_workers.push_back(worker);
+}
+
+// the calls of the batches are merged in order after the calls painted so far,
+// it must be done before any serial call, or the paint order (and hit test order) is changed
+void NanoPainterPrivate::finishBatches()
+{
+    if (m_batch) {
+        if (m_batches.empty()) {
+            // it is not worth the thread switch if there is only one batch
+            auto batch = m_batch.get();
+            m_batches.push_back(std::move(m_batch));
+            runBatch(batch);
+            m_batchesDone.release();
+        } else {
+            submitBatch();
+        }
+    }
+
+    if (m_batches.empty()) return;
+    m_batchesDone.acquire(int(m_batches.size()));
+
+    for (auto& batch : m_batches) {
+        std::move(batch->calls.begin(), batch->calls.end(), std::back_inserter(m_pendingCalls));
+        if (m_hitTestEnabled) m_hitIndex.append(batch->hitIndex);
+        m_batchStatistics.drawCalls += batch->statistics.drawCalls;
+        m_batchStatistics.triangles += batch->statistics.triangles;
+        m_batchStatistics.culledCalls += batch->statistics.culledCalls;
+    }
+
+    m_batches.clear();
+
+    // painter without deferred mode updates the nodes while painting, so the serial calls come after them
+    if (!m_deferred) onRenderFlush();
+}
+
+void NanoPainterPrivate::discardBatches()
+{
+    m_batch.reset();
+    if (m_batches.empty()) return;
+    m_batchesDone.acquire(int(m_batches.size()));
+    m_batches.clear();
+}
+
 static void premultiplyColor(float* rgba, const NVGcolor& c)
 {
     rgba[0] = c.r * c.a;
@@ -693,13 +1096,28 @@ static void xformToMat3x4(float* m3, float* t)
     m3[11] = 0.0f;
 }
 
-static void updateMaterial(QQuickWindow* window, NanoMaterial* mat, NanoMaterial::UniformBuffer& info, const NVGpaint& paint, const QImage& image)
+static void updatePaintInfo(NanoMaterial::UniformBuffer& info, const NVGpaint& paint, NanoBrush::Ramp ramp)
 {
     premultiplyColor(info.innerColor, paint.innerColor);
     premultiplyColor(info.outerColor, paint.outerColor);
     memcpy(info.extent, paint.extent, sizeof(info.extent));
 
-    if (paint.image) {
+    if (ramp != NanoBrush::Ramp::None) {
+        info.radius = paint.radius;
+        info.feather = paint.feather;
+
+        switch (ramp) {
+        case NanoBrush::Ramp::Conical:
+            info.type = NanoMaterial::TypeConicalGradient;
+            break;
+        case NanoBrush::Ramp::Focal:
+            info.type = NanoMaterial::TypeFocalGradient;
+            break;
+        default:
+            info.type = NanoMaterial::TypeGradientRamp;
+            break;
+        }
+    } else if (paint.image) {
         info.type = NanoMaterial::TypeImagePattern;
     } else {
         info.radius = paint.radius;
@@ -715,31 +1133,111 @@ static void updateMaterial(QQuickWindow* window, NanoMaterial* mat, NanoMaterial
     float invxform[6];
     nvgTransformInverse(invxform, paint.xform);
     xformToMat3x4(info.paintMatrix, invxform);
+}
 
-    mat->setTextureImage(window, image);
-    mat->setInfo(info);
+static void updateScissorInfo(NanoMaterial::UniformBuffer& info, const NVGscissor& scissor, float fringe)
+{
+    // negative extent means no scissor, keep the default that masks nothing
+    if (scissor.extent[0] < -0.5f || scissor.extent[1] < -0.5f) return;
+
+    float invxform[6];
+    nvgTransformInverse(invxform, scissor.xform);
+    xformToMat3x4(info.scissorMatrix, invxform);
+
+    auto& t = scissor.xform;
+    info.scissorExtent[0] = scissor.extent[0];
+    info.scissorExtent[1] = scissor.extent[1];
+    info.scissorScale[0] = qSqrt(t[0] * t[0] + t[2] * t[2]) / fringe;
+    info.scissorScale[1] = qSqrt(t[1] * t[1] + t[3] * t[3]) / fringe;
+}
+
+// image pattern has its pattern coordinate and texture sub-rect in the vertices, so the patterns in the same atlas can be batched
+static const QSGGeometry::AttributeSet& vertexAttributesOf(const NanoMaterial::UniformBuffer& info)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    if (info.type == NanoMaterial::TypeImagePattern) return NanoMaterial::patternAttributes();
+#else
+    Q_UNUSED(info)
+#endif
+    return QSGGeometry::defaultAttributes_TexturedPoint2D();
+}
+
+// the extra room repeats the last vertex, so it only adds degenerate triangles
+static void copyVertexData(QSGGeometry* geo, const NVGvertex* vertices, int vertexCount, bool pad)
+{
+    auto count = pad ? geo->vertexCount() : vertexCount;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    if (geo->attributes() == NanoMaterial::patternAttributes().attributes) {
+        auto vertexBuf = static_cast<NanoMaterial::PatternVertex*>(geo->vertexData());
+        for (int i = 0; i < count; ++i) {
+            auto& v = vertices[qMin(i, vertexCount - 1)];
+            vertexBuf[i].x = v.x;
+            vertexBuf[i].y = v.y;
+            vertexBuf[i].u = v.u;
+            vertexBuf[i].v = v.v;
+        }
+        return;
+    }
+#endif
+
+    Q_ASSERT(geo->sizeOfVertex() == sizeof(NVGvertex));
+    auto vertexBuf = static_cast<NVGvertex*>(geo->vertexData());
+    memcpy(vertexBuf, vertices, vertexCount * sizeof(NVGvertex));
+    std::fill(vertexBuf + vertexCount, vertexBuf + count, vertices[vertexCount - 1]);
 }
 
-void NanoPainterPrivate::beginUpdateVertexData(const QString& name, NanoPainter::Composite composite, const NVGpaint& paint, const QImage& image, float fringe, float width, float threshold)
+static void updateMaterial(QQuickWindow* window, NanoMaterial* mat, NanoMaterial::UniformBuffer& info, const QImage& image, QSGGeometry* geo)
 {
-    auto& mat = m_updateMaterial;
-    m_updateMaterialTaken = false;
+    // color material has no texture at all, so it is batched regardless of the image
+    if (NanoMaterial::isTextured(info)) {
+        mat->setTextureImage(window, image, info.type != NanoMaterial::TypeImagePattern);
 
-    if (!m_freeMaterials.isEmpty()) {
-        mat = static_cast<NanoMaterial*>(m_freeMaterials.takeFirst());
+        auto texture = mat->texture();
+        auto rect = texture ? texture->normalizedTextureSubRect() : QRectF(0, 0, 1, 1);
+        info.textureRect[0] = float(rect.x());
+        info.textureRect[1] = float(rect.y());
+        info.textureRect[2] = float(rect.width());
+        info.textureRect[3] = float(rect.height());
     } else {
-        mat = new NanoMaterial();
+        mat->setTexture(nullptr);
     }
 
-    NanoMaterial::UniformBuffer info;
-    info.strokeMultiply = (width * 0.5f + fringe * 0.5f) / fringe;
-    info.strokeThreshold = threshold;
-    info.edgeAA = m_params.edgeAntiAlias;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    // the vertices take the pattern coordinate and sub-rect, so the material is the same for the whole atlas
+    if (info.type == NanoMaterial::TypeImagePattern && geo->attributes() == NanoMaterial::patternAttributes().attributes) {
+        NanoMaterial::updatePatternVertices(static_cast<NanoMaterial::PatternVertex*>(geo->vertexData()), geo->vertexCount(), info);
+        NanoMaterial::toBatchedPattern(info);
+        geo->markVertexDataDirty();
+    }
+#else
+    Q_UNUSED(geo)
+#endif
+
+    mat->setInfo(info);
+}
+
+void NanoPainterPrivate::beginUpdateVertexData(const QString& name, NanoPainter::Composite composite, const NVGpaint& paint, const NVGscissor& scissor, NanoBrush::Ramp ramp, const QImage& image, float fringe, float width, float threshold)
+{
+    auto& u = m_update;
+    u.name = name;
+    u.composite = composite;
+    u.image = image;
+    u.strokeWidth = width;
+
+    u.info = NanoMaterial::UniformBuffer();
+    u.info.strokeMultiply = (width * 0.5f + fringe * 0.5f) / fringe;
+    u.info.strokeThreshold = threshold;
+    u.info.edgeAA = m_params.edgeAntiAlias;
+    updatePaintInfo(u.info, paint, ramp);
+    updateScissorInfo(u.info, scissor, fringe);
 
-    mat->setName(name);
-    mat->setStrokeWidth(width);
-    mat->setCompositeOperation(composite);
-    updateMaterial(m_item->window(), mat, info, paint, image);
+    // textureRect is not set yet, it is derived from the image
+    u.hash = qHash(name);
+    u.hash = qHash(int(composite), u.hash);
+    u.hash = qHash(width, u.hash);
+    u.hash = qHash(image.cacheKey(), u.hash);
+    u.hash = qHashBits(&u.info, sizeof(u.info), u.hash);
 }
 
 void NanoPainterPrivate::updateVertexDataForStroke(const NVGpath* paths, int npaths)
@@ -822,53 +1320,81 @@ void NanoPainterPrivate::updateVertexData(unsigned mode, int vertexCount, int in
         m_node = new QSGNode();
     }
 
-    QSGGeometryNode* node;
-    QSGGeometry* geo;
+    // painter without deferred mode updates the nodes while painting, so it is fetched on first use
+    if (!m_resources) {
+        m_resources = NanoResourceManager::forWindow(m_item->window());
+        if (!m_resources) return;
+    }
+
+    m_updateVertexBuf.resize(vertexCount);
+    m_updateIndexBuf.resize(indexCount);
+    loader(m_updateVertexBuf.data(), indexCount > 0 ? m_updateIndexBuf.data() : nullptr);
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    if (m_renderNodeEnabled) {
+        beginRenderNodeUpdate();
+        m_renderNode->addDraw(m_update.name, m_update.composite, m_update.info, m_update.image,
+                mode, m_updateVertexBuf.data(), vertexCount, m_updateIndexBuf.data(), indexCount);
+        return;
+    }
+#endif
+
+    auto hash = qHash(mode, m_update.hash);
+    hash = qHashBits(m_updateVertexBuf.data(), vertexCount * sizeof(NVGvertex), hash);
+    if (indexCount > 0) hash = qHashBits(m_updateIndexBuf.data(), indexCount * sizeof(uint), hash);
+
+    NanoGeometryNode* node;
     if (m_nextFreeNode) {
         node = m_nextFreeNode;
-        node->setMaterial(m_updateMaterial);
-        m_nextFreeNode = static_cast<QSGGeometryNode*>(node->nextSibling());
+        m_nextFreeNode = static_cast<NanoGeometryNode*>(node->nextSibling());
 
-        geo = node->geometry();
-        geo->allocate(vertexCount, indexCount);
+        // same content as last time, leave it alone so the renderer does not need to upload it again
+        if (node->m_hash == hash && node->m_vertexCount == vertexCount && node->m_indexCount == indexCount
+                && node->geometry()->drawingMode() == mode) {
+            node->m_changedCount = 0;
+            return;
+        }
+
+        node->reserve(vertexCount, indexCount, vertexAttributesOf(m_update.info));
+        node->updateDataPattern();
     } else {
-        geo = new QSGGeometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), vertexCount, indexCount, QSGGeometry::UnsignedIntType);
-        geo->setVertexDataPattern(QSGGeometry::StaticPattern);
-        geo->setIndexDataPattern(QSGGeometry::StaticPattern);
-
-        node = new QSGGeometryNode();
-        node->setFlags(QSGNode::OwnsGeometry | QSGNode::OwnedByParent);
-        node->setGeometry(geo);
-        node->setMaterial(m_updateMaterial);
+        node = new NanoGeometryNode(m_resources, vertexCount, indexCount, vertexAttributesOf(m_update.info));
         m_node->appendChildNode(node);
     }
 
-    Q_ASSERT(geo->sizeOfVertex() == sizeof(NVGvertex));
+    auto geo = node->geometry();
     geo->setDrawingMode(mode);
     geo->markVertexDataDirty();
 
-    auto vertexBuf = static_cast<NVGvertex*>(geo->vertexData());
-    uint* indexBuf = nullptr;
+    // the extra room repeats the last vertex (or index), so it only adds degenerate triangles
+    if (vertexCount > 0) {
+        copyVertexData(geo, m_updateVertexBuf.data(), vertexCount, indexCount == 0);
+    }
 
     if (indexCount > 0) {
+        auto indexBuf = geo->indexDataAsUInt();
         geo->markIndexDataDirty();
-        indexBuf = geo->indexDataAsUInt();
+        memcpy(indexBuf, m_updateIndexBuf.data(), indexCount * sizeof(uint));
+        std::fill(indexBuf + indexCount, indexBuf + geo->indexCount(), indexBuf[indexCount - 1]);
     }
 
-    loader(vertexBuf, indexBuf);
-
-    node->setFlag(QSGNode::OwnsMaterial, !m_updateMaterialTaken);
+    // after the vertices, since image pattern may fill its pattern coordinate into them
+    auto mat = static_cast<NanoMaterial*>(node->material());
+    auto info = m_update.info;
+    mat->setName(m_update.name);
+    mat->setStrokeWidth(m_update.strokeWidth);
+    mat->setCompositeOperation(m_update.composite);
+    updateMaterial(m_item->window(), mat, info, m_update.image, geo);
+
+    node->m_hash = hash;
+    node->m_vertexCount = vertexCount;
+    node->m_indexCount = indexCount;
     node->markDirty(QSGNode::DirtyGeometry | QSGNode::DirtyMaterial);
-    m_updateMaterialTaken = true;
 }
 
 void NanoPainterPrivate::endUpdateVertexData()
 {
-    if (!m_updateMaterialTaken) {
-        m_freeMaterials += m_updateMaterial;
-    }
-    m_updateMaterial = nullptr;
-    m_updateMaterialTaken = false;
+    m_update.image = {};
 }
 
 //---------------------------------------------------------------------------
@@ -892,7 +1418,81 @@ NanoPainter::~NanoPainter()
 
 float NanoPainter::itemPixelRatio() const
 {
-    return d->itemPixelRatio();
+    return d->m_itemPixelRatio;
+}
+
+void NanoPainter::setItemPixelRatio(float ratio)
+{
+    d->m_fixedPixelRatio = qMax(0.0f, ratio);
+}
+
+bool NanoPainter::isRenderNodeEnabled() const
+{
+    return d->m_renderNodeEnabled;
+}
+
+void NanoPainter::setRenderNodeEnabled(bool enabled)
+{
+    d->m_renderNodeEnabled = enabled;
+}
+
+bool NanoPainter::isParallelTessellationEnabled() const
+{
+    return d->m_parallelTessellationEnabled;
+}
+
+void NanoPainter::setParallelTessellationEnabled(bool enabled)
+{
+    if (d->m_parallelTessellationEnabled == enabled) return;
+
+    // it could be switched in the middle of painting, the queued calls must come before the next serial call
+    if (!enabled) d->finishBatches();
+    d->m_parallelTessellationEnabled = enabled;
+}
+
+QRectF NanoPainter::visibleRect() const
+{
+    return d->m_visibleRect;
+}
+
+void NanoPainter::setVisibleRect(const QRectF& rect)
+{
+    d->m_visibleRect = rect;
+    if (rect.isNull()) {
+        nvgInternalCullBounds(d->m_nvg, nullptr);
+    } else {
+        float bounds[4] = { float(rect.left()), float(rect.top()), float(rect.right()), float(rect.bottom()) };
+        nvgInternalCullBounds(d->m_nvg, bounds);
+    }
+}
+
+NanoPainter::Statistics NanoPainter::statistics() const
+{
+    return d->m_statistics;
+}
+
+bool NanoPainter::isHitTestEnabled() const
+{
+    return d->m_hitTestEnabled;
+}
+
+void NanoPainter::setHitTestEnabled(bool enabled)
+{
+    d->m_hitTestEnabled = enabled;
+    if (!enabled) {
+        d->m_hitIndex.clear();
+        d->m_lastHitIndex.clear();
+    }
+}
+
+QString NanoPainter::pathAt(const QPointF& point) const
+{
+    return d->m_lastHitIndex.pathAt(point);
+}
+
+QStringList NanoPainter::pathsIn(const QRectF& rect) const
+{
+    return d->m_lastHitIndex.pathsIn(rect);
 }
 
 void NanoPainter::reset()
@@ -994,6 +1594,31 @@ void NanoPainter::postShear(qreal sh, qreal sv)
     d->applyTransform();
 }
 
+void NanoPainter::setClipRect(float x, float y, float width, float height)
+{
+    nvgScissor(d->m_nvg, x, y, width, height);
+}
+
+void NanoPainter::setClipRect(const QRectF& rect)
+{
+    setClipRect(float(rect.x()), float(rect.y()), float(rect.width()), float(rect.height()));
+}
+
+void NanoPainter::intersectClipRect(float x, float y, float width, float height)
+{
+    nvgIntersectScissor(d->m_nvg, x, y, width, height);
+}
+
+void NanoPainter::intersectClipRect(const QRectF& rect)
+{
+    intersectClipRect(float(rect.x()), float(rect.y()), float(rect.width()), float(rect.height()));
+}
+
+void NanoPainter::resetClipRect()
+{
+    nvgResetScissor(d->m_nvg);
+}
+
 NanoPainter::Composite NanoPainter::compositeOperation() const
 {
     return d->m_composite;
@@ -1016,6 +1641,17 @@ void NanoPainter::setMiterLimit(qreal limit)
     nvgMiterLimit(d->m_nvg, float(limit));
 }
 
+qreal NanoPainter::simplifyTolerance() const
+{
+    return d->m_simplifyTolerance;
+}
+
+void NanoPainter::setSimplifyTolerance(qreal tolerance)
+{
+    d->m_simplifyTolerance = tolerance;
+    nvgInternalSimplifyTolerance(d->m_nvg, float(tolerance));
+}
+
 Qt::PenCapStyle NanoPainter::capStyle() const
 {
     return d->m_capStyle;
@@ -1233,18 +1869,19 @@ void NanoPainter::addPolygon(const QPolygonF& path)
 {
     if (path.count() < 2) return;
 
-    auto n = path.size() - 1;
-    moveTo(path.first());
+    auto closed = path.isClosed();
+    auto count = closed ? path.count() - 1 : path.count();
+    addPolygon(reinterpret_cast<const qreal*>(path.constData()), count, closed);
+}
 
-    for (int i = 1; i < n; ++i) {
-        lineTo(path[i]);
-    }
+void NanoPainter::addPolygon(const float* points, int count, bool closed)
+{
+    nvgPolygon(d->m_nvg, points, count, closed);
+}
 
-    if (path.isClosed()) {
-        closeSubpath();
-    } else {
-        lineTo(path[n]);
-    }
+void NanoPainter::addPolygon(const double* points, int count, bool closed)
+{
+    nvgPolygonDouble(d->m_nvg, points, count, closed);
 }
 
 void NanoPainter::addPath(const QPainterPath& path)
@@ -1280,12 +1917,21 @@ void NanoPainter::stroke()
     }
 
     nvgDashOffset(d->m_nvg, float(d->m_dashOffset * d->m_strokeWidth));
-    nvgStroke(d->m_nvg);
+
+    if (d->m_parallelTessellationEnabled) {
+        d->queueJob(true);
+    } else {
+        nvgStroke(d->m_nvg);
+    }
 }
 
 void NanoPainter::fill()
 {
-    nvgFill(d->m_nvg);
+    if (d->m_parallelTessellationEnabled) {
+        d->queueJob(false);
+    } else {
+        nvgFill(d->m_nvg);
+    }
 }
 
 QSGNode* NanoPainter::updatePaintNode(QSGNode* node)
@@ -1304,34 +1950,74 @@ float NanoPainter::itemPixelRatio(QQuickItem* item)
     return qMax(0.5, pr);
 }
 
+float NanoPainter::itemPixelRatioBucket(float ratio)
+{
+    // the nearest power of sqrt(2)
+    if (ratio <= 0) return 1;
+    return float(qPow(2, qRound(std::log2(ratio) * 2) * 0.5));
+}
+
+QRectF NanoPainter::itemVisibleRect(QQuickItem* item)
+{
+    if (!item || !item->window()) return {};
+
+    auto window = item->window();
+    auto rect = item->mapRectFromScene(QRectF(0, 0, window->width(), window->height()));
+
+    // clip by every clipping ancestor, including the item itself
+    for (auto p = item; p; p = p->parentItem()) {
+        if (!p->clip()) continue;
+        rect &= item->mapRectFromItem(p, p->clipRect());
+    }
+
+    // keep it non-null, so nothing is painted if the item is not visible at all
+    if (rect.isEmpty()) return QRectF(0, 0, -1, -1);
+    return rect;
+}
+
 static bool updatePaintNodeBrush(QQuickItem* item, QSGNode* root, const QString& name, const NanoBrush& brush)
 {
     if (!root || name.isEmpty() || !item || !item->window()) return false;
 
-    auto node = root->firstChild();
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    if (root->firstChild() && root->firstChild()->type() == QSGNode::RenderNodeType) {
+        auto renderNode = static_cast<NanoRenderNode*>(root->firstChild());
+        return renderNode->updateDraws(name, [&](NanoMaterial::UniformBuffer& info, QImage& image) {
+            updatePaintInfo(info, brush.paint(), brush.ramp());
+            image = brush.image();
+        });
+    }
+#endif
+
+    auto node = static_cast<NanoGeometryNode*>(root->firstChild());
     bool updated = false;
+    bool repaint = false;
 
     while (node) {
-        auto mat = static_cast<NanoMaterial*>(static_cast<QSGGeometryNode*>(node)->material());
+        auto mat = static_cast<NanoMaterial*>(node->material());
         if (mat->name() == name) {
             auto info = mat->info();
-            updateMaterial(item->window(), mat, info, brush.paint(), brush.image());
-            updated = true;
-
-            auto rest = node;
-            while (rest) {
-                auto m = static_cast<QSGGeometryNode*>(rest)->material();
-                if (m == mat) {
-                    rest->markDirty(QSGNode::DirtyMaterial);
-                }
-                rest = rest->nextSibling();
+            updatePaintInfo(info, brush.paint(), brush.ramp());
+
+            // geometry with pattern vertices only takes image pattern, other brush needs repaint.
+            // plain geometry still takes image pattern, it is just not batched with other patterns
+            auto geo = node->geometry();
+            auto plain = geo->attributes() == QSGGeometry::defaultAttributes_TexturedPoint2D().attributes;
+            if (!plain && geo->attributes() != vertexAttributesOf(info).attributes) {
+                repaint = true;
+            } else {
+                updateMaterial(item->window(), mat, info, brush.image(), geo);
+                updated = true;
+
+                // the content is changed outside of the painter, so it must be updated on next repaint
+                node->m_hash = 0;
+                node->markDirty(plain ? QSGNode::DirtyState(QSGNode::DirtyMaterial) : QSGNode::DirtyMaterial | QSGNode::DirtyGeometry);
             }
-            break;
         }
-        node = node->nextSibling();
+        node = static_cast<NanoGeometryNode*>(node->nextSibling());
     }
 
-    return updated;
+    return updated && !repaint;
 }
 
 bool NanoPainter::updatePaintNodeStrokeBrush(QQuickItem* item, QSGNode* node, const QString& name, const NanoBrush& brush)
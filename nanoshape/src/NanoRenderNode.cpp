@@ -0,0 +1,563 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#include "NanoRenderNode.h"
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+
+#include <QFile>
+#include <QQuickWindow>
+#include <QSGGeometry>
+#include <QSGTexture>
+
+#include <rhi/qrhi.h>
+
+#include <array>
+
+//---------------------------------------------------------------------------
+
+static QShader loadShader(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) return {};
+    return QShader::fromSerialized(file.readAll());
+}
+
+static const QShader& vertexShader()
+{
+    static const QShader shader = loadShader(QLatin1String(":/NanoShape/NanoShader.vert.qsb"));
+    return shader;
+}
+
+static const QShader& fragmentShader(NanoMaterial::Variant variant)
+{
+    static const auto shaders = [] {
+        std::array<QShader, NanoMaterial::VariantCount> shaders;
+        for (int i = 0; i < NanoMaterial::VariantCount; ++i) {
+            auto name = NanoMaterial::variantName(NanoMaterial::Variant(i));
+            shaders[i] = loadShader(QLatin1String(":/NanoShape/NanoShader%1.frag.qsb").arg(name));
+        }
+        return shaders;
+    }();
+    return shaders[variant];
+}
+
+// same blend factors as the material of geometry node
+static void compositeBlend(NanoPainter::Composite op, QRhiGraphicsPipeline::TargetBlend& blend)
+{
+    using Factor = QRhiGraphicsPipeline::BlendFactor;
+    auto src = Factor::One;
+    auto dst = Factor::OneMinusSrcAlpha;
+
+    switch (op) {
+    case NanoPainter::Composite::SourceOver:
+        break;
+    case NanoPainter::Composite::SourceIn:
+        src = Factor::DstAlpha;
+        dst = Factor::Zero;
+        break;
+    case NanoPainter::Composite::SourceOut:
+        src = Factor::OneMinusDstAlpha;
+        dst = Factor::Zero;
+        break;
+    case NanoPainter::Composite::Atop:
+        src = Factor::DstAlpha;
+        dst = Factor::OneMinusSrcAlpha;
+        break;
+    case NanoPainter::Composite::DestinationOver:
+        src = Factor::OneMinusDstAlpha;
+        dst = Factor::One;
+        break;
+    case NanoPainter::Composite::DestinationIn:
+        src = Factor::Zero;
+        dst = Factor::SrcAlpha;
+        break;
+    case NanoPainter::Composite::DestinationOut:
+        src = Factor::Zero;
+        dst = Factor::OneMinusSrcAlpha;
+        break;
+    case NanoPainter::Composite::DestinationAtop:
+        src = Factor::OneMinusDstAlpha;
+        dst = Factor::SrcAlpha;
+        break;
+    case NanoPainter::Composite::Lighter:
+        src = Factor::One;
+        dst = Factor::One;
+        break;
+    case NanoPainter::Composite::Copy:
+        src = Factor::One;
+        dst = Factor::Zero;
+        break;
+    case NanoPainter::Composite::Xor:
+        src = Factor::OneMinusDstAlpha;
+        dst = Factor::OneMinusSrcAlpha;
+        break;
+    }
+
+    blend.enable = true;
+    blend.srcColor = src;
+    blend.dstColor = dst;
+    blend.srcAlpha = src;
+    blend.dstAlpha = dst;
+}
+
+// create or grow the buffer, return true if it is created again
+static bool ensureBuffer(QRhi* rhi, QRhiBuffer*& buffer, QRhiBuffer::Type type, QRhiBuffer::UsageFlags usage, quint32 size)
+{
+    if (buffer && buffer->type() == type && buffer->size() >= size) return false;
+
+    auto capacity = buffer && buffer->type() == type ? qMax(size, buffer->size() + buffer->size() / 2) : size;
+    delete buffer;
+    buffer = rhi->newBuffer(type, usage, capacity);
+    if (!buffer->create()) {
+        delete buffer;
+        buffer = nullptr;
+    }
+    return true;
+}
+
+static inline bool isSamePosition(const NVGvertex& a, const NVGvertex& b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+//---------------------------------------------------------------------------
+
+NanoRenderNode::NanoRenderNode(QQuickWindow* window)
+    : m_window(window)
+{
+    // do nothing
+}
+
+NanoRenderNode::~NanoRenderNode()
+{
+    releaseResources();
+
+    if (m_textureOwner) {
+        for (auto key : m_textureKeys) {
+            m_textureOwner->releaseTexture(key);
+        }
+    }
+}
+
+void NanoRenderNode::beginUpdate(const QSharedPointer<NanoResourceManager>& resources)
+{
+    m_resources = resources;
+    m_draws.clear();
+    m_vertices.clear();
+    m_indices.clear();
+    m_rect = {};
+}
+
+void NanoRenderNode::addDraw(const QString& name, NanoPainter::Composite composite, const NanoMaterial::UniformBuffer& info, const QImage& image,
+        unsigned mode, const NVGvertex* vertexData, int vertexCount, const uint* indexData, int indexCount)
+{
+    if (vertexCount <= 0) return;
+
+    auto base = quint32(m_vertices.size());
+    auto firstIndex = int(m_indices.size());
+    m_vertices.insert(m_vertices.end(), vertexData, vertexData + vertexCount);
+
+    if (indexCount > 0) {
+        for (int i = 0; i < indexCount; ++i) {
+            m_indices.push_back(base + indexData[i]);
+        }
+    } else if (mode == QSGGeometry::DrawTriangleStrip) {
+        // strip is turned into triangle list, so all the draws can share the same pipeline,
+        // and the degenerate triangles that join the sub paths are dropped
+        for (int i = 0; i + 2 < vertexCount; ++i) {
+            auto& a = vertexData[i];
+            auto& b = vertexData[i + 1];
+            auto& c = vertexData[i + 2];
+            if (isSamePosition(a, b) || isSamePosition(b, c) || isSamePosition(a, c)) continue;
+            m_indices.push_back(base + i);
+            m_indices.push_back(base + i + 1);
+            m_indices.push_back(base + i + 2);
+        }
+    } else {
+        for (int i = 0; i < vertexCount; ++i) {
+            m_indices.push_back(base + i);
+        }
+    }
+
+    auto count = int(m_indices.size()) - firstIndex;
+    if (count <= 0) return;
+
+    auto minX = vertexData[0].x;
+    auto minY = vertexData[0].y;
+    auto maxX = minX;
+    auto maxY = minY;
+    for (int i = 1; i < vertexCount; ++i) {
+        minX = qMin(minX, vertexData[i].x);
+        minY = qMin(minY, vertexData[i].y);
+        maxX = qMax(maxX, vertexData[i].x);
+        maxY = qMax(maxY, vertexData[i].y);
+    }
+    m_rect |= QRectF(minX, minY, maxX - minX, maxY - minY);
+
+    // consecutive draws of the same paint are merged into one
+    if (!m_draws.empty()) {
+        auto& last = m_draws.back();
+        if (last.name == name && last.composite == composite && last.image.cacheKey() == image.cacheKey()
+                && last.info == info && last.firstIndex + last.indexCount == firstIndex) {
+            last.indexCount += count;
+            return;
+        }
+    }
+
+    m_draws.push_back({ name, composite, info, NanoMaterial::variantOf(info), image, nullptr, firstIndex, count });
+}
+
+void NanoRenderNode::endUpdate()
+{
+    updateTextures();
+    m_dataVersion++;
+    m_dataDirty = true;
+    m_uniformDirty = true;
+    markDirty(QSGNode::DirtyMaterial);
+}
+
+bool NanoRenderNode::updateDraws(const QString& name, const std::function<void(NanoMaterial::UniformBuffer& info, QImage& image)>& update)
+{
+    bool updated = false;
+    for (auto& draw : m_draws) {
+        if (draw.name != name) continue;
+        update(draw.info, draw.image);
+        updated = true;
+    }
+    if (!updated) return false;
+
+    updateTextures();
+    m_uniformDirty = true;
+    markDirty(QSGNode::DirtyMaterial);
+    return true;
+}
+
+void NanoRenderNode::updateTextures()
+{
+    std::vector<qint64> keys;
+
+    for (auto& draw : m_draws) {
+        draw.variant = NanoMaterial::variantOf(draw.info);
+        draw.texture = nullptr;
+        if (!m_resources || !NanoMaterial::isTextured(draw.info)) continue;
+
+        draw.texture = m_resources->acquireTexture(draw.image, draw.info.type != NanoMaterial::TypeImagePattern);
+        if (draw.texture != m_resources->dummyTexture()) keys.push_back(draw.image.cacheKey());
+
+        auto rect = draw.texture ? draw.texture->normalizedTextureSubRect() : QRectF(0, 0, 1, 1);
+        draw.info.textureRect[0] = float(rect.x());
+        draw.info.textureRect[1] = float(rect.y());
+        draw.info.textureRect[2] = float(rect.width());
+        draw.info.textureRect[3] = float(rect.height());
+    }
+
+    // release after acquire, so the texture still in use is not dropped
+    if (m_textureOwner) {
+        for (auto key : m_textureKeys) {
+            m_textureOwner->releaseTexture(key);
+        }
+    }
+
+    m_textureKeys.swap(keys);
+    m_textureOwner = m_resources;
+
+    // the textures may be gone, so are the bindings of them
+    qDeleteAll(m_textureBindings);
+    m_textureBindings.clear();
+}
+
+QSGRenderNode::StateFlags NanoRenderNode::changedStates() const
+{
+    return ViewportState | ScissorState | StencilState | BlendState;
+}
+
+QSGRenderNode::RenderingFlags NanoRenderNode::flags() const
+{
+    return BoundedRectRendering | NoExternalRendering;
+}
+
+QRectF NanoRenderNode::rect() const
+{
+    return m_rect;
+}
+
+void NanoRenderNode::prepare()
+{
+    auto rhi = m_window->rhi();
+    if (!rhi || m_draws.empty()) return;
+
+    auto batch = rhi->nextResourceUpdateBatch();
+
+    // content that changes on every frame is streamed, otherwise it is uploaded once into static buffer
+    m_changedFrames = m_dataDirty ? qMin(m_changedFrames + 1, STREAMING_AFTER_FRAMES) : 0;
+    if (m_changedFrames >= STREAMING_AFTER_FRAMES) {
+        prepareStreamingData(rhi);
+    } else if (m_dataDirty || (m_vertexBuffer && m_vertexBuffer->type() != QRhiBuffer::Static)) {
+        auto vertexSize = quint32(m_vertices.size() * sizeof(NVGvertex));
+        auto indexSize = quint32(m_indices.size() * sizeof(quint32));
+        ensureBuffer(rhi, m_vertexBuffer, QRhiBuffer::Static, QRhiBuffer::VertexBuffer, vertexSize);
+        ensureBuffer(rhi, m_indexBuffer, QRhiBuffer::Static, QRhiBuffer::IndexBuffer, indexSize);
+        if (m_vertexBuffer) batch->uploadStaticBuffer(m_vertexBuffer, 0, vertexSize, m_vertices.data());
+        if (m_indexBuffer) batch->uploadStaticBuffer(m_indexBuffer, 0, indexSize, m_indices.data());
+    }
+    m_dataDirty = false;
+
+    // each draw has its own block in the uniform buffer, selected by dynamic offset
+    m_uniformStride = quint32(rhi->ubufAligned(NanoMaterial::UniformBlockSize));
+    auto uniformSize = quint32(m_uniformStride * m_draws.size());
+    if (ensureBuffer(rhi, m_uniformBuffer, QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, uniformSize)) {
+        delete m_colorBindings;
+        m_colorBindings = nullptr;
+        qDeleteAll(m_textureBindings);
+        m_textureBindings.clear();
+        m_uniformDirty = true;
+    }
+
+    auto matrix = *projectionMatrix() * *this->matrix();
+    auto opacity = float(inheritedOpacity());
+
+    if (m_uniformBuffer && (m_uniformDirty || matrix != m_matrix || opacity != m_opacity)) {
+        QByteArray data(int(uniformSize), 0);
+        for (size_t i = 0; i < m_draws.size(); ++i) {
+            auto block = data.data() + i * m_uniformStride;
+            memcpy(block, matrix.constData(), 64);
+            memcpy(block + 64, &opacity, sizeof(float));
+            NanoMaterial::writeUniformBlock(block, m_draws[i].variant, m_draws[i].info);
+        }
+        batch->updateDynamicBuffer(m_uniformBuffer, 0, uniformSize, data.constData());
+
+        m_matrix = matrix;
+        m_opacity = opacity;
+        m_uniformDirty = false;
+    }
+
+    QSGTexture* committed = nullptr;
+    for (auto& draw : m_draws) {
+        if (!draw.texture || draw.texture == committed) continue;
+        draw.texture->commitTextureOperations(rhi, batch);
+        committed = draw.texture;
+    }
+
+    commandBuffer()->resourceUpdate(batch);
+}
+
+void NanoRenderNode::prepareStreamingData(QRhi* rhi)
+{
+    auto vertexSize = quint32(m_vertices.size() * sizeof(NVGvertex));
+    auto indexSize = quint32(m_indices.size() * sizeof(quint32));
+
+    // dynamic buffer has one native buffer per frame in flight, so it is written without waiting for the gpu
+    auto created = ensureBuffer(rhi, m_vertexBuffer, QRhiBuffer::Dynamic, QRhiBuffer::VertexBuffer, vertexSize);
+    created |= ensureBuffer(rhi, m_indexBuffer, QRhiBuffer::Dynamic, QRhiBuffer::IndexBuffer, indexSize);
+    if (!m_vertexBuffer || !m_indexBuffer) return;
+
+    auto frames = size_t(qMax(1, rhi->resourceLimit(QRhi::FramesInFlight)));
+    if (created || m_slotVersions.size() != frames) {
+        m_slotVersions.assign(frames, 0);
+    }
+
+    // each frame slot is written only if it has not seen the current data yet
+    auto slot = size_t(rhi->currentFrameSlot()) % frames;
+    if (m_slotVersions[slot] == m_dataVersion) return;
+
+    auto vertexData = m_vertexBuffer->beginFullDynamicBufferUpdateForCurrentFrame();
+    memcpy(vertexData, m_vertices.data(), vertexSize);
+    m_vertexBuffer->endFullDynamicBufferUpdateForCurrentFrame();
+
+    auto indexData = m_indexBuffer->beginFullDynamicBufferUpdateForCurrentFrame();
+    memcpy(indexData, m_indices.data(), indexSize);
+    m_indexBuffer->endFullDynamicBufferUpdateForCurrentFrame();
+
+    m_slotVersions[slot] = m_dataVersion;
+}
+
+void NanoRenderNode::render(const RenderState* state)
+{
+    if (m_draws.empty() || !m_vertexBuffer || !m_indexBuffer || !m_uniformBuffer) return;
+
+    auto cb = commandBuffer();
+    auto rt = renderTarget();
+
+    // pipelines are bound to the format of render pass, and must be created again if it is changed
+    auto format = rt->renderPassDescriptor()->serializedFormat();
+    if (format != m_renderPassFormat) {
+        qDeleteAll(m_pipelines);
+        m_pipelines.clear();
+        m_renderPassFormat = format;
+    }
+
+    auto stencil = state->stencilEnabled();
+    auto scissor = state->scissorEnabled();
+    auto size = rt->pixelSize();
+    QRhiCommandBuffer::VertexInput vertexInput(m_vertexBuffer, 0);
+    QRhiGraphicsPipeline* current = nullptr;
+
+    for (size_t i = 0; i < m_draws.size(); ++i) {
+        auto& draw = m_draws[i];
+        auto ps = pipeline(draw, stencil, scissor);
+        auto srb = bindings(draw);
+        if (!ps || !srb) continue;
+
+        // dynamic states are set again whenever the pipeline is switched
+        if (ps != current) {
+            cb->setGraphicsPipeline(ps);
+            cb->setViewport(QRhiViewport(0, 0, size.width(), size.height()));
+            if (scissor) {
+                auto r = state->scissorRect();
+                cb->setScissor(QRhiScissor(r.x(), r.y(), r.width(), r.height()));
+            }
+            if (stencil) cb->setStencilRef(state->stencilValue());
+            cb->setVertexInput(0, 1, &vertexInput, m_indexBuffer, 0, QRhiCommandBuffer::IndexUInt32);
+            current = ps;
+        }
+
+        QRhiCommandBuffer::DynamicOffset offset(0, quint32(i * m_uniformStride));
+        cb->setShaderResources(srb, 1, &offset);
+        cb->drawIndexed(quint32(draw.indexCount), 1, quint32(draw.firstIndex));
+    }
+}
+
+void NanoRenderNode::releaseResources()
+{
+    qDeleteAll(m_pipelines);
+    m_pipelines.clear();
+    qDeleteAll(m_textureBindings);
+    m_textureBindings.clear();
+
+    delete m_colorBindings;
+    m_colorBindings = nullptr;
+    delete m_sampler;
+    m_sampler = nullptr;
+    delete m_uniformBuffer;
+    m_uniformBuffer = nullptr;
+    delete m_indexBuffer;
+    m_indexBuffer = nullptr;
+    delete m_vertexBuffer;
+    m_vertexBuffer = nullptr;
+
+    m_renderPassFormat.clear();
+    m_slotVersions.clear();
+    m_opacity = -1;
+    m_dataDirty = true;
+    m_uniformDirty = true;
+}
+
+QRhiGraphicsPipeline* NanoRenderNode::pipeline(const Draw& draw, bool stencil, bool scissor)
+{
+    auto key = quint32(draw.variant) | quint32(draw.composite) << 4 | quint32(stencil) << 8 | quint32(scissor) << 9;
+    auto it = m_pipelines.constFind(key);
+    if (it != m_pipelines.constEnd()) return *it;
+
+    // the bindings of the draw have the same layout as the other draws of the same variant
+    auto layout = bindings(draw);
+    if (!layout) return nullptr;
+
+    auto rt = renderTarget();
+    auto ps = m_window->rhi()->newGraphicsPipeline();
+    ps->setShaderStages({
+        { QRhiShaderStage::Vertex, vertexShader() },
+        { QRhiShaderStage::Fragment, fragmentShader(draw.variant) },
+    });
+
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({ { quint32(sizeof(NVGvertex)) } });
+    inputLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float2, 0 },
+        { 0, 1, QRhiVertexInputAttribute::Float2, quint32(2 * sizeof(float)) },
+    });
+    ps->setVertexInputLayout(inputLayout);
+
+    QRhiGraphicsPipeline::TargetBlend blend;
+    compositeBlend(draw.composite, blend);
+    ps->setTargetBlends({ blend });
+
+    // same stencil test as the scene graph uses for clipping
+    QRhiGraphicsPipeline::Flags flags;
+    if (scissor) flags |= QRhiGraphicsPipeline::UsesScissor;
+    if (stencil) {
+        flags |= QRhiGraphicsPipeline::UsesStencilRef;
+        QRhiGraphicsPipeline::StencilOpState op;
+        op.compareOp = QRhiGraphicsPipeline::Equal;
+        op.failOp = QRhiGraphicsPipeline::Keep;
+        op.depthFailOp = QRhiGraphicsPipeline::Keep;
+        op.passOp = QRhiGraphicsPipeline::Keep;
+        ps->setStencilTest(true);
+        ps->setStencilFront(op);
+        ps->setStencilBack(op);
+        ps->setStencilReadMask(0xFF);
+        ps->setStencilWriteMask(0);
+    }
+
+    ps->setFlags(flags);
+    ps->setTopology(QRhiGraphicsPipeline::Triangles);
+    ps->setShaderResourceBindings(layout);
+    ps->setRenderPassDescriptor(rt->renderPassDescriptor());
+    ps->setSampleCount(rt->sampleCount());
+
+    if (!ps->create()) {
+        delete ps;
+        ps = nullptr;
+    }
+
+    m_pipelines.insert(key, ps);
+    return ps;
+}
+
+QRhiShaderResourceBindings* NanoRenderNode::bindings(const Draw& draw)
+{
+    auto rhi = m_window->rhi();
+    auto stages = QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage;
+    auto uniform = QRhiShaderResourceBinding::uniformBufferWithDynamicOffset(0, stages, m_uniformBuffer, NanoMaterial::UniformBlockSize);
+
+    if (!draw.texture) {
+        if (!m_colorBindings) {
+            m_colorBindings = rhi->newShaderResourceBindings();
+            m_colorBindings->setBindings({ uniform });
+            m_colorBindings->create();
+        }
+        return m_colorBindings;
+    }
+
+    auto texture = draw.texture->rhiTexture();
+    if (!texture) return nullptr;
+
+    auto& srb = m_textureBindings[texture];
+    if (!srb) {
+        if (!m_sampler) {
+            m_sampler = rhi->newSampler(QRhiSampler::Linear, QRhiSampler::Linear, QRhiSampler::None,
+                    QRhiSampler::ClampToEdge, QRhiSampler::ClampToEdge);
+            m_sampler->create();
+        }
+
+        srb = rhi->newShaderResourceBindings();
+        srb->setBindings({ uniform, QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, texture, m_sampler) });
+        srb->create();
+    }
+    return srb;
+}
+
+#endif
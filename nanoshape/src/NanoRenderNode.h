@@ -0,0 +1,126 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+
+#include <QtGlobal>
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+
+#include "NanoMaterial.h"
+#include "NanoResourceManager.h"
+#include "nanovg.h"
+
+#include <QHash>
+#include <QMatrix4x4>
+#include <QSGRenderNode>
+
+#include <functional>
+#include <vector>
+
+class QQuickWindow;
+class QRhi;
+class QRhiBuffer;
+class QRhiGraphicsPipeline;
+class QRhiSampler;
+class QRhiShaderResourceBindings;
+class QRhiTexture;
+
+//---------------------------------------------------------------------------
+
+// single node that draws all the paint calls of a painter, the vertices of all calls are packed
+// into one vertex buffer, and the uniforms into one dynamic uniform buffer at per call offsets.
+// the vertices are streamed into dynamic buffer instead, if they are changed on every frame.
+class NanoRenderNode : public QSGRenderNode
+{
+public:
+    explicit NanoRenderNode(QQuickWindow* window);
+    virtual ~NanoRenderNode();
+
+    void beginUpdate(const QSharedPointer<NanoResourceManager>& resources);
+    void addDraw(const QString& name, NanoPainter::Composite composite, const NanoMaterial::UniformBuffer& info, const QImage& image,
+            unsigned mode, const NVGvertex* vertexData, int vertexCount, const uint* indexData, int indexCount);
+    void endUpdate();
+
+    // update the paint of the named draws in place, return false if there is no such draw
+    bool updateDraws(const QString& name, const std::function<void(NanoMaterial::UniformBuffer& info, QImage& image)>& update);
+
+    virtual StateFlags changedStates() const override;
+    virtual RenderingFlags flags() const override;
+    virtual QRectF rect() const override;
+    virtual void prepare() override;
+    virtual void render(const RenderState* state) override;
+    virtual void releaseResources() override;
+
+private:
+    static constexpr int STREAMING_AFTER_FRAMES = 3;
+
+    struct Draw
+    {
+        QString name;
+        NanoPainter::Composite composite;
+        NanoMaterial::UniformBuffer info;
+        NanoMaterial::Variant variant;
+        QImage image;
+        QSGTexture* texture;
+        int firstIndex;
+        int indexCount;
+    };
+
+    void updateTextures();
+    void prepareStreamingData(QRhi* rhi);
+    QRhiGraphicsPipeline* pipeline(const Draw& draw, bool stencil, bool scissor);
+    QRhiShaderResourceBindings* bindings(const Draw& draw);
+
+private:
+    QQuickWindow* m_window;
+    QSharedPointer<NanoResourceManager> m_resources;
+    std::vector<Draw> m_draws;
+    std::vector<NVGvertex> m_vertices;
+    std::vector<quint32> m_indices;
+    std::vector<qint64> m_textureKeys;
+    QSharedPointer<NanoResourceManager> m_textureOwner;
+    QRectF m_rect;
+
+    QRhiBuffer* m_vertexBuffer = nullptr;
+    QRhiBuffer* m_indexBuffer = nullptr;
+    QRhiBuffer* m_uniformBuffer = nullptr;
+    QRhiSampler* m_sampler = nullptr;
+    QRhiShaderResourceBindings* m_colorBindings = nullptr;
+    QHash<QRhiTexture*, QRhiShaderResourceBindings*> m_textureBindings;
+    QHash<quint32, QRhiGraphicsPipeline*> m_pipelines;
+    QVector<quint32> m_renderPassFormat;
+    std::vector<quint64> m_slotVersions;
+    QMatrix4x4 m_matrix;
+    float m_opacity = -1;
+    quint32 m_uniformStride = 0;
+    quint64 m_dataVersion = 0;
+    int m_changedFrames = 0;
+    bool m_dataDirty = false;
+    bool m_uniformDirty = false;
+};
+
+#endif
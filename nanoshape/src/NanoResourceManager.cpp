@@ -0,0 +1,231 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#include "NanoResourceManager.h"
+#include "NanoMaterial.h"
+
+#include <QMutex>
+#include <QQuickWindow>
+#include <QSGGeometry>
+#include <QSGTexture>
+
+//---------------------------------------------------------------------------
+
+// unused gradient ramps are small and likely to be used again, so some of them are kept
+static constexpr int MAX_UNUSED_GRADIENT_RAMPS = 64;
+
+// bound the pools, so a burst of short lived items does not hold the memory forever
+static constexpr int MAX_POOLED_MATERIALS = 256;
+static constexpr int MAX_POOLED_GEOMETRIES = 256;
+static constexpr int MAX_POOLED_GEOMETRY_VERTICES = 16 * 1024;
+static constexpr int MAX_POOLED_GEOMETRY_SLACK = 2;
+
+// each window may have its own render thread, so the registry must be locked
+static QMutex s_managersMutex;
+static QHash<QQuickWindow*, QSharedPointer<NanoResourceManager>> s_managers;
+
+QSharedPointer<NanoResourceManager> NanoResourceManager::forWindow(QQuickWindow* window)
+{
+    if (!window) return {};
+
+    QMutexLocker lock(&s_managersMutex);
+    auto& manager = s_managers[window];
+    if (!manager) manager.reset(new NanoResourceManager(window));
+    return manager;
+}
+
+NanoResourceManager::NanoResourceManager(QQuickWindow* window)
+    : m_window(window)
+{
+    auto remove = [window] {
+        QSharedPointer<NanoResourceManager> manager;
+        {
+            QMutexLocker lock(&s_managersMutex);
+            manager = s_managers.take(window);
+        }
+        if (manager) manager->invalidate();
+    };
+
+    // materials may still hold the manager, but the textures must be gone with the scene graph
+    m_invalidatedConnection = QObject::connect(window, &QQuickWindow::sceneGraphInvalidated, window, remove, Qt::DirectConnection);
+    m_destroyedConnection = QObject::connect(window, &QObject::destroyed, remove);
+    m_renderedConnection = QObject::connect(window, &QQuickWindow::afterRendering, window, [this] {
+        purge();
+    }, Qt::DirectConnection);
+}
+
+NanoResourceManager::~NanoResourceManager()
+{
+    invalidate();
+}
+
+void NanoResourceManager::invalidate()
+{
+    if (!m_window) return;
+    m_window = nullptr;
+
+    QObject::disconnect(m_invalidatedConnection);
+    QObject::disconnect(m_destroyedConnection);
+    QObject::disconnect(m_renderedConnection);
+
+    for (auto& entry : m_textures) {
+        delete entry.texture;
+    }
+    m_textures.clear();
+    m_unused = 0;
+    m_unusedRamps = 0;
+
+    delete m_dummyTexture;
+    m_dummyTexture = nullptr;
+
+    qDeleteAll(m_freeMaterials);
+    m_freeMaterials.clear();
+    qDeleteAll(m_freeGeometries);
+    m_freeGeometries.clear();
+}
+
+QSGTexture* NanoResourceManager::acquireTexture(const QImage& image, bool gradientRamp)
+{
+    if (!m_window || image.isNull()) return dummyTexture();
+
+    auto it = m_textures.find(image.cacheKey());
+    if (it != m_textures.end()) {
+        if (it->refCount++ == 0) {
+            m_unused--;
+            if (it->gradientRamp) m_unusedRamps--;
+        }
+        return it->texture;
+    }
+
+    // small image is packed into the shared atlas of the scene graph, the shader maps into its sub-rect
+    auto texture = m_window->createTextureFromImage(image, QQuickWindow::TextureCanUseAtlas);
+    if (!texture) return dummyTexture();
+
+    m_textures.insert(image.cacheKey(), { texture, 1, gradientRamp });
+    return texture;
+}
+
+void NanoResourceManager::releaseTexture(qint64 key)
+{
+    auto it = m_textures.find(key);
+    if (it == m_textures.end()) return;
+
+    // unused texture is kept until the frame is rendered, so it can be picked up again by other material
+    if (--it->refCount == 0) {
+        m_unused++;
+        if (it->gradientRamp) m_unusedRamps++;
+    }
+}
+
+QSGTexture* NanoResourceManager::dummyTexture()
+{
+    if (!m_dummyTexture && m_window) {
+        QImage dummyImage(4, 4, QImage::Format_RGBA8888_Premultiplied);
+        dummyImage.fill(Qt::transparent);
+        m_dummyTexture = m_window->createTextureFromImage(dummyImage);
+    }
+    return m_dummyTexture;
+}
+
+NanoMaterial* NanoResourceManager::takeMaterial()
+{
+    if (m_freeMaterials.empty()) return new NanoMaterial();
+
+    auto material = m_freeMaterials.back();
+    m_freeMaterials.pop_back();
+    return material;
+}
+
+void NanoResourceManager::recycleMaterial(NanoMaterial* material)
+{
+    if (!m_window || int(m_freeMaterials.size()) >= MAX_POOLED_MATERIALS) {
+        delete material;
+        return;
+    }
+
+    // the pooled material must not keep the texture alive
+    material->setTexture(nullptr);
+    m_freeMaterials.push_back(material);
+}
+
+QSGGeometry* NanoResourceManager::takeGeometry(int vertexCount, int indexCount, const QSGGeometry::AttributeSet& attributes)
+{
+    // best fit, the extra room of the pooled geometry is kept and padded by the node,
+    // but the one too large is left in the pool, since all of its room is uploaded
+    auto best = m_freeGeometries.end();
+    for (auto it = m_freeGeometries.begin(); it != m_freeGeometries.end(); ++it) {
+        auto geometry = *it;
+        if (geometry->attributes() != attributes.attributes) continue;
+        if (geometry->vertexCount() < vertexCount || geometry->vertexCount() > vertexCount * MAX_POOLED_GEOMETRY_SLACK) continue;
+        if (geometry->indexCount() < indexCount || (geometry->indexCount() > 0) != (indexCount > 0)) continue;
+        if (geometry->indexCount() > indexCount * MAX_POOLED_GEOMETRY_SLACK) continue;
+        if (best == m_freeGeometries.end() || geometry->vertexCount() < (*best)->vertexCount()) best = it;
+    }
+
+    if (best == m_freeGeometries.end()) {
+        auto geometry = new QSGGeometry(attributes, vertexCount, indexCount, QSGGeometry::UnsignedIntType);
+        geometry->setVertexDataPattern(QSGGeometry::StaticPattern);
+        geometry->setIndexDataPattern(QSGGeometry::StaticPattern);
+        return geometry;
+    }
+
+    auto geometry = *best;
+    *best = m_freeGeometries.back();
+    m_freeGeometries.pop_back();
+    return geometry;
+}
+
+void NanoResourceManager::recycleGeometry(QSGGeometry* geometry)
+{
+    if (!m_window || int(m_freeGeometries.size()) >= MAX_POOLED_GEOMETRIES
+            || geometry->vertexCount() > MAX_POOLED_GEOMETRY_VERTICES) {
+        delete geometry;
+        return;
+    }
+
+    geometry->setVertexDataPattern(QSGGeometry::StaticPattern);
+    geometry->setIndexDataPattern(QSGGeometry::StaticPattern);
+    m_freeGeometries.push_back(geometry);
+}
+
+void NanoResourceManager::purge()
+{
+    // keep the unused gradient ramps, unless there are too many of them
+    auto purgeRamps = m_unusedRamps > MAX_UNUSED_GRADIENT_RAMPS;
+    if (m_unused == 0 || (m_unused == m_unusedRamps && !purgeRamps)) return;
+
+    for (auto it = m_textures.begin(); it != m_textures.end();) {
+        if (it->refCount == 0 && (!it->gradientRamp || purgeRamps)) {
+            delete it->texture;
+            it = m_textures.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (purgeRamps) m_unusedRamps = 0;
+    m_unused = m_unusedRamps;
+}
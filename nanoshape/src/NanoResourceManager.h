@@ -0,0 +1,96 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QMetaObject>
+#include <QSGGeometry>
+#include <QSharedPointer>
+
+#include <vector>
+
+class NanoMaterial;
+class QQuickWindow;
+class QSGTexture;
+
+//---------------------------------------------------------------------------
+
+// per window render resources: textures of image patterns and gradient ramps, the dummy texture,
+// and the pools of materials and geometries recycled from the geometry nodes of all the painters.
+// it is created on first use and torn down when the scene graph of the window is invalidated,
+// all the functions except forWindow() are only called in the render thread of the window.
+class NanoResourceManager
+{
+public:
+    ~NanoResourceManager();
+
+    static QSharedPointer<NanoResourceManager> forWindow(QQuickWindow* window);
+
+    // return the texture for image and add reference to it, null image return dummy texture (not referenced)
+    QSGTexture* acquireTexture(const QImage& image, bool gradientRamp = false);
+    void releaseTexture(qint64 key);
+
+    // bound to the sampler if the material has no texture, but its shader does sample it
+    QSGTexture* dummyTexture();
+
+    // borrow from the pool or create new one, the geometry has room for at least the given count
+    NanoMaterial* takeMaterial();
+    QSGGeometry* takeGeometry(int vertexCount, int indexCount,
+            const QSGGeometry::AttributeSet& attributes = QSGGeometry::defaultAttributes_TexturedPoint2D());
+
+    // return to the pool, or delete it if the pool is full
+    void recycleMaterial(NanoMaterial* material);
+    void recycleGeometry(QSGGeometry* geometry);
+
+    bool isValid() const { return m_window != nullptr; }
+
+private:
+    explicit NanoResourceManager(QQuickWindow* window);
+
+    void invalidate();
+    void purge();
+
+private:
+    struct Entry
+    {
+        QSGTexture* texture;
+        int refCount;
+        bool gradientRamp;
+    };
+
+    QQuickWindow* m_window;
+    QHash<qint64, Entry> m_textures;
+    QSGTexture* m_dummyTexture = nullptr;
+    std::vector<NanoMaterial*> m_freeMaterials;
+    std::vector<QSGGeometry*> m_freeGeometries;
+    QMetaObject::Connection m_invalidatedConnection;
+    QMetaObject::Connection m_destroyedConnection;
+    QMetaObject::Connection m_renderedConnection;
+    int m_unused = 0;
+    int m_unusedRamps = 0;
+};
@@ -25,9 +25,16 @@
 //
 
 #include "NanoShape.h"
+#include "NanoImageCache.h"
 
+#include <QJSValue>
+#include <QQmlContext>
+#include <QQmlEngine>
 #include <QQuickWindow>
 
+#include <functional>
+#include <numeric>
+
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 #define geometryChange geometryChanged
 Q_DECLARE_METATYPE(NanoBrush)
@@ -39,7 +46,7 @@ NanoShapePainter::NanoShapePainter(QQuickItem* item)
     : QObject(item)
     , NanoPainter(item)
 {
-    // do nothing
+    connect(NanoImageCache::instance(), &NanoImageCache::imageReady, this, &NanoShapePainter::onImageReady);
 }
 
 NanoShapePainter::~NanoShapePainter()
@@ -122,6 +129,21 @@ void NanoShapePainter::postShear(qreal sh, qreal sv)
     NanoPainter::postShear(sh, sv);
 }
 
+void NanoShapePainter::setClipRect(float x, float y, float width, float height)
+{
+    NanoPainter::setClipRect(x, y, width, height);
+}
+
+void NanoShapePainter::intersectClipRect(float x, float y, float width, float height)
+{
+    NanoPainter::intersectClipRect(x, y, width, height);
+}
+
+void NanoShapePainter::resetClipRect()
+{
+    NanoPainter::resetClipRect();
+}
+
 void NanoShapePainter::setCompositeStyle(int op)
 {
     NanoPainter::setCompositeOperation(Composite(op));
@@ -147,6 +169,11 @@ void NanoShapePainter::setMiterLimit(qreal limit)
     NanoPainter::setMiterLimit(limit);
 }
 
+void NanoShapePainter::setSimplifyTolerance(qreal tolerance)
+{
+    NanoPainter::setSimplifyTolerance(tolerance);
+}
+
 void NanoShapePainter::setCapStyle(Qt::PenCapStyle style)
 {
     NanoPainter::setCapStyle(style);
@@ -192,27 +219,111 @@ QVariant NanoShapePainter::radialGradient(const QColor& innerColor, const QColor
     return QVariant::fromValue(NanoBrush::radialGradient(innerColor, outerColor, { cx, cy }, innerRadius, outerRadius));
 }
 
-QVariant NanoShapePainter::imagePattern(const QUrl& imageUrl, const QRectF& part, qreal rotation, qreal opacity)
+static QGradientStops toGradientStops(const QVariant& value)
 {
-    QString path;
-    if (imageUrl.isLocalFile()) {
-        path = imageUrl.toLocalFile();
-    } else if (imageUrl.scheme() == "qrc") {
-        path = imageUrl.path();
-        if (path.startsWith('/')) {
-            path = ':' + path;
+    auto list = value;
+    if (list.userType() == qMetaTypeId<QJSValue>()) list = list.value<QJSValue>().toVariant();
+
+    QGradientStops stops;
+    for (auto& item : list.toList()) {
+        auto v = item;
+        if (v.userType() == qMetaTypeId<QJSValue>()) v = v.value<QJSValue>().toVariant();
+
+        QVariant pos;
+        QVariant color;
+        if (auto obj = v.value<QObject*>()) {
+            pos = obj->property("position");
+            color = obj->property("color");
+        } else if (v.userType() == QMetaType::QVariantMap) {
+            auto map = v.toMap();
+            pos = map.value(QStringLiteral("position"));
+            color = map.value(QStringLiteral("color"));
         } else {
-            path = QLatin1String(":/") + path;
+            auto pair = v.toList();
+            if (pair.size() != 2) continue;
+            pos = pair[0];
+            color = pair[1];
         }
-    } else {
-        return QColor(Qt::black);
+
+        auto c = color.value<QColor>();
+        if (!pos.isValid() || !c.isValid()) continue;
+        stops.append(QGradientStop(qBound(0.0, pos.toDouble(), 1.0), c));
     }
+    return stops;
+}
+
+QVariant NanoShapePainter::linearGradient(const QVariant& stops, qreal sx, qreal sy, qreal ex, qreal ey)
+{
+    return QVariant::fromValue(NanoBrush::linearGradient(toGradientStops(stops), { sx, sy }, { ex, ey }));
+}
 
-    QImage image(path);
+QVariant NanoShapePainter::boxGradient(const QVariant& stops,
+        qreal bx, qreal by, qreal bw, qreal bh, qreal cornerRadius, qreal feather)
+{
+    return QVariant::fromValue(NanoBrush::boxGradient(toGradientStops(stops), { bx, by, bw, bh }, cornerRadius, feather));
+}
+
+QVariant NanoShapePainter::radialGradient(const QVariant& stops, qreal cx, qreal cy, qreal innerRadius, qreal outerRadius)
+{
+    return QVariant::fromValue(NanoBrush::radialGradient(toGradientStops(stops), { cx, cy }, innerRadius, outerRadius));
+}
+
+QVariant NanoShapePainter::focalGradient(const QVariant& stops, qreal cx, qreal cy, qreal radius, qreal fx, qreal fy)
+{
+    return QVariant::fromValue(NanoBrush::focalGradient(toGradientStops(stops), { cx, cy }, radius, { fx, fy }));
+}
+
+QVariant NanoShapePainter::conicalGradient(const QVariant& stops, qreal cx, qreal cy, qreal angle)
+{
+    return QVariant::fromValue(NanoBrush::conicalGradient(toGradientStops(stops), { cx, cy }, angle));
+}
+
+static QVariant toImagePattern(const QImage& image, bool pending, const QRectF& part, qreal rotation, qreal opacity)
+{
+    if (pending) return QColor(Qt::transparent);
     if (image.isNull()) return QColor(Qt::black);
     return QVariant::fromValue(NanoBrush::imagePattern(image, part, rotation, opacity));
 }
 
+QVariant NanoShapePainter::imagePattern(const QString& imageUrl, const QRectF& part, qreal rotation, qreal opacity)
+{
+    auto item = qobject_cast<QQuickItem*>(parent());
+    auto context = item ? qmlContext(item) : nullptr;
+    auto url = context ? context->resolvedUrl(QUrl(imageUrl)) : QUrl(imageUrl);
+
+    bool pending = false;
+    auto image = NanoImageCache::instance()->image(url, context ? context->engine() : nullptr, &pending);
+    if (pending) m_pendingImages.insert(url.toString());
+    return toImagePattern(image, pending, part, rotation, opacity);
+}
+
+QVariant NanoShapePainter::imagePattern(const QUrl& imageUrl, const QRectF& part, qreal rotation, qreal opacity)
+{
+    bool pending = false;
+    auto image = NanoImageCache::instance()->image(imageUrl, nullptr, &pending);
+    return toImagePattern(image, pending, part, rotation, opacity);
+}
+
+void NanoShapePainter::clearPendingImages()
+{
+    m_pendingImages.clear();
+}
+
+int NanoShapePainter::imageCacheLimit()
+{
+    return NanoImageCache::instance()->cacheLimit();
+}
+
+void NanoShapePainter::setImageCacheLimit(int bytes)
+{
+    NanoImageCache::instance()->setCacheLimit(bytes);
+}
+
+void NanoShapePainter::onImageReady(const QString& key)
+{
+    if (m_pendingImages.remove(key)) emit pendingImageReady();
+}
+
 void NanoShapePainter::beginPath()
 {
     NanoPainter::beginPath();
@@ -278,8 +389,88 @@ void NanoShapePainter::addCircle(float centerX, float centerY, float radius)
     NanoPainter::addCircle(centerX, centerY, radius);
 }
 
+// Raw content of qml ArrayBuffer or typed array.
+// ArrayBuffer is passed to c++ as QByteArray, and is assumed to be Float32 content,
+// typed array is passed as QJSValue, only Float32Array and Float64Array are accepted.
+struct NanoArrayData
+{
+    QByteArray buffer;
+    const char* data = nullptr;
+    int size = 0;
+    int elementSize = 0;
+
+    int count() const { return elementSize > 0 ? size / elementSize : 0; }
+    const float* floatData() const { return elementSize == sizeof(float) ? reinterpret_cast<const float*>(data) : nullptr; }
+    const double* doubleData() const { return elementSize == sizeof(double) ? reinterpret_cast<const double*>(data) : nullptr; }
+};
+
+static bool toArrayData(const QVariant& v, NanoArrayData& array)
+{
+    if (v.userType() == QMetaType::QByteArray) {
+        array.buffer = v.toByteArray();
+        array.data = array.buffer.constData();
+        array.size = array.buffer.size();
+        array.elementSize = sizeof(float);
+        return true;
+    }
+
+    if (v.userType() != qMetaTypeId<QJSValue>()) return false;
+
+    auto value = v.value<QJSValue>();
+    if (!value.isObject()) return false;
+
+    // the tag of Object.prototype.toString is the intrinsic name of the typed array,
+    // unlike constructor.name it is the same for subclassed array or renamed constructor
+    auto objectPrototype = value;
+    while (objectPrototype.prototype().isObject()) {
+        objectPrototype = objectPrototype.prototype();
+    }
+    auto type = objectPrototype.property(QStringLiteral("toString")).callWithInstance(value).toString();
+    if (type == QLatin1String("[object Float32Array]")) {
+        array.elementSize = sizeof(float);
+    } else if (type == QLatin1String("[object Float64Array]")) {
+        array.elementSize = sizeof(double);
+    } else {
+        return false;
+    }
+
+    auto buffer = value.property(QStringLiteral("buffer"));
+    auto bufferSize = buffer.property(QStringLiteral("byteLength")).toInt();
+    auto offset = value.property(QStringLiteral("byteOffset")).toInt();
+    auto size = value.property(QStringLiteral("byteLength")).toInt();
+    if (offset < 0 || size < 0 || offset + size > bufferSize) return false;
+
+    // the view of part of the buffer (like subarray) is sliced first, so only the viewed bytes are taken
+    if (size < bufferSize) {
+        buffer = buffer.property(QStringLiteral("slice")).callWithInstance(buffer, { offset, offset + size });
+    }
+
+    array.buffer = buffer.toVariant().toByteArray();
+    if (array.buffer.size() != size) return false;
+
+    array.data = array.buffer.constData();
+    array.size = size;
+    return true;
+}
+
 void NanoShapePainter::addPolygon(const QVariant& v)
 {
+    NanoArrayData array;
+    if (toArrayData(v, array)) {
+        auto n = array.count() / 2;
+        if (n < 2) return;
+
+        // same as QPolygonF, the polygon is closed if the last point is the same as the first one
+        if (auto p = array.floatData()) {
+            auto closed = p[0] == p[n * 2 - 2] && p[1] == p[n * 2 - 1];
+            NanoPainter::addPolygon(p, closed ? n - 1 : n, closed);
+        } else if (auto p = array.doubleData()) {
+            auto closed = p[0] == p[n * 2 - 2] && p[1] == p[n * 2 - 1];
+            NanoPainter::addPolygon(p, closed ? n - 1 : n, closed);
+        }
+        return;
+    }
+
     QPolygonF poly;
     if (v.canConvert<QPolygonF>()) {
         poly = v.value<QPolygonF>();
@@ -302,6 +493,232 @@ void NanoShapePainter::addPolygon(const QVariant& v)
     NanoPainter::addPolygon(poly);
 }
 
+// convert the count, code or enum of the command, NaN, infinity or the value out of range is rejected,
+// since the conversion of them to int is undefined. the range is compared in double, so it is exact.
+template <typename T>
+static bool toCommandInt(T value, int min, int max, int& result)
+{
+    if (!(double(value) >= min && double(value) <= max)) return false;
+    result = int(value);
+    return true;
+}
+
+static bool isCapStyle(int style)
+{
+    return style == Qt::FlatCap || style == Qt::SquareCap || style == Qt::RoundCap;
+}
+
+static bool isJoinStyle(int style)
+{
+    return style == Qt::MiterJoin || style == Qt::BevelJoin || style == Qt::RoundJoin || style == Qt::SvgMiterJoin;
+}
+
+template <typename T>
+static bool executeCommands(NanoPainter& painter, const T* buf, int n)
+{
+    auto toColor = [](const T* p) {
+        return QColor::fromRgbF(float(p[0]), float(p[1]), float(p[2]), float(p[3]));
+    };
+
+    for (int i = 0; i < n;) {
+        int cmd;
+        if (!toCommandInt(buf[i++], 0, NanoShapePainter::CommandSetSimplifyTolerance, cmd)) return false;
+        auto p = buf + i;
+        auto avail = n - i;
+
+        switch (cmd) {
+        case NanoShapePainter::CommandBeginPath:
+            painter.beginPath();
+            break;
+        case NanoShapePainter::CommandMoveTo:
+            if (avail < 2) return false;
+            painter.moveTo(float(p[0]), float(p[1]));
+            i += 2;
+            break;
+        case NanoShapePainter::CommandLineTo:
+            if (avail < 2) return false;
+            painter.lineTo(float(p[0]), float(p[1]));
+            i += 2;
+            break;
+        case NanoShapePainter::CommandBezierTo:
+            if (avail < 6) return false;
+            painter.bezierTo(float(p[0]), float(p[1]), float(p[2]), float(p[3]), float(p[4]), float(p[5]));
+            i += 6;
+            break;
+        case NanoShapePainter::CommandQuadTo:
+            if (avail < 4) return false;
+            painter.quadTo(float(p[0]), float(p[1]), float(p[2]), float(p[3]));
+            i += 4;
+            break;
+        case NanoShapePainter::CommandArcTo:
+            if (avail < 5) return false;
+            painter.arcTo(float(p[0]), float(p[1]), float(p[2]), float(p[3]), float(p[4]));
+            i += 5;
+            break;
+        case NanoShapePainter::CommandCloseSubpath:
+            painter.closeSubpath();
+            break;
+        case NanoShapePainter::CommandAddArc:
+            if (avail < 6) return false;
+            painter.addArc(float(p[0]), float(p[1]), float(p[2]), float(p[3]), float(p[4]), p[5] != 0);
+            i += 6;
+            break;
+        case NanoShapePainter::CommandAddRect:
+            if (avail < 4) return false;
+            painter.addRect(float(p[0]), float(p[1]), float(p[2]), float(p[3]));
+            i += 4;
+            break;
+        case NanoShapePainter::CommandAddRoundedRect:
+            if (avail < 5) return false;
+            painter.addRoundedRect(float(p[0]), float(p[1]), float(p[2]), float(p[3]), float(p[4]));
+            i += 5;
+            break;
+        case NanoShapePainter::CommandAddEllipse:
+            if (avail < 4) return false;
+            painter.addEllipse(float(p[0]), float(p[1]), float(p[2]), float(p[3]));
+            i += 4;
+            break;
+        case NanoShapePainter::CommandAddCircle:
+            if (avail < 3) return false;
+            painter.addCircle(float(p[0]), float(p[1]), float(p[2]));
+            i += 3;
+            break;
+        case NanoShapePainter::CommandAddPolygon: {
+            int count;
+            if (avail < 1 || !toCommandInt(p[0], 0, (avail - 1) / 2, count)) return false;
+            auto pts = p + 1;
+            if (count >= 2) {
+                // same as QPolygonF, the polygon is closed if the last point is the same as the first one
+                auto closed = pts[0] == pts[count * 2 - 2] && pts[1] == pts[count * 2 - 1];
+                painter.addPolygon(pts, closed ? count - 1 : count, closed);
+            }
+            i += 1 + count * 2;
+            break;
+        }
+        case NanoShapePainter::CommandAsInverted:
+            painter.asInverted();
+            break;
+        case NanoShapePainter::CommandStroke:
+            painter.stroke();
+            break;
+        case NanoShapePainter::CommandFill:
+            painter.fill();
+            break;
+        case NanoShapePainter::CommandSetStrokeWidth:
+            if (avail < 1) return false;
+            painter.setStrokeWidth(p[0]);
+            i += 1;
+            break;
+        case NanoShapePainter::CommandSetMiterLimit:
+            if (avail < 1) return false;
+            painter.setMiterLimit(p[0]);
+            i += 1;
+            break;
+        case NanoShapePainter::CommandSetCapStyle: {
+            int style;
+            if (avail < 1 || !toCommandInt(p[0], 0, Qt::RoundCap, style) || !isCapStyle(style)) return false;
+            painter.setCapStyle(Qt::PenCapStyle(style));
+            i += 1;
+            break;
+        }
+        case NanoShapePainter::CommandSetJoinStyle: {
+            int style;
+            if (avail < 1 || !toCommandInt(p[0], 0, Qt::SvgMiterJoin, style) || !isJoinStyle(style)) return false;
+            painter.setJoinStyle(Qt::PenJoinStyle(style));
+            i += 1;
+            break;
+        }
+        case NanoShapePainter::CommandSetCompositeStyle: {
+            int op;
+            if (avail < 1 || !toCommandInt(p[0], 0, int(NanoPainter::Composite::Xor), op)) return false;
+            painter.setCompositeOperation(NanoPainter::Composite(op));
+            i += 1;
+            break;
+        }
+        case NanoShapePainter::CommandSetDashOffset:
+            if (avail < 1) return false;
+            painter.setDashOffset(p[0]);
+            i += 1;
+            break;
+        case NanoShapePainter::CommandSetDashPattern: {
+            int count;
+            if (avail < 1 || !toCommandInt(p[0], 0, avail - 1, count)) return false;
+            painter.setDashPattern(QVector<qreal>(p + 1, p + 1 + count));
+            i += 1 + count;
+            break;
+        }
+        case NanoShapePainter::CommandSetStrokeColor:
+            if (avail < 4) return false;
+            painter.setStrokeBrush(toColor(p));
+            i += 4;
+            break;
+        case NanoShapePainter::CommandSetFillColor:
+            if (avail < 4) return false;
+            painter.setFillBrush(toColor(p));
+            i += 4;
+            break;
+        case NanoShapePainter::CommandResetTransform:
+            painter.resetTransform();
+            break;
+        case NanoShapePainter::CommandSetTransform:
+            if (avail < 6) return false;
+            painter.setTransform(QTransform(p[0], p[1], p[2], p[3], p[4], p[5]));
+            i += 6;
+            break;
+        case NanoShapePainter::CommandPreTranslate:
+            if (avail < 2) return false;
+            painter.preTranslate(p[0], p[1]);
+            i += 2;
+            break;
+        case NanoShapePainter::CommandPreScale:
+            if (avail < 2) return false;
+            painter.preScale(p[0], p[1]);
+            i += 2;
+            break;
+        case NanoShapePainter::CommandPreRotate:
+            if (avail < 1) return false;
+            painter.preRotate(p[0]);
+            i += 1;
+            break;
+        case NanoShapePainter::CommandSetClipRect:
+            if (avail < 4) return false;
+            painter.setClipRect(float(p[0]), float(p[1]), float(p[2]), float(p[3]));
+            i += 4;
+            break;
+        case NanoShapePainter::CommandIntersectClipRect:
+            if (avail < 4) return false;
+            painter.intersectClipRect(float(p[0]), float(p[1]), float(p[2]), float(p[3]));
+            i += 4;
+            break;
+        case NanoShapePainter::CommandResetClipRect:
+            painter.resetClipRect();
+            break;
+        case NanoShapePainter::CommandSetSimplifyTolerance:
+            if (avail < 1) return false;
+            painter.setSimplifyTolerance(p[0]);
+            i += 1;
+            break;
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool NanoShapePainter::execute(const QVariant& commands)
+{
+    NanoArrayData array;
+    if (!toArrayData(commands, array)) return false;
+
+    if (auto p = array.floatData()) {
+        return executeCommands(*this, p, array.count());
+    } else if (auto p = array.doubleData()) {
+        return executeCommands(*this, p, array.count());
+    }
+    return false;
+}
+
 void NanoShapePainter::asInverted()
 {
     NanoPainter::asInverted();
@@ -319,12 +736,21 @@ void NanoShapePainter::fill()
 
 //---------------------------------------------------------------------------
 
+// the scale is considered settled if it is not changed for this period
+static const int PIXEL_RATIO_SETTLE_MSEC = 200;
+
 NanoShape::NanoShape(QQuickItem* parent)
     : QQuickItem(parent)
-    , m_painter(this)
 {
+    addLayer({});
     setFlag(ItemHasContents);
     setAntialiasing(true);
+
+    m_pixelRatioTimer.setSingleShot(true);
+    m_pixelRatioTimer.setInterval(PIXEL_RATIO_SETTLE_MSEC);
+    connect(&m_pixelRatioTimer, &QTimer::timeout, this, [this] {
+        setPixelRatio(currentPixelRatio());
+    });
 }
 
 NanoShape::~NanoShape()
@@ -332,12 +758,149 @@ NanoShape::~NanoShape()
     // do nothing
 }
 
+void NanoShape::addLayer(const QString& name)
+{
+    auto& layer = m_layers.emplace_back();
+    layer.name = name;
+    layer.painter.reset(new NanoShapePainter(this));
+    layer.painter->setRenderNodeEnabled(m_renderNodeEnabled);
+    layer.painter->setParallelTessellationEnabled(m_parallelTessellationEnabled);
+    layer.painter->setHitTestEnabled(m_hitTestEnabled);
+    layer.painter->setItemPixelRatio(m_itemPixelRatio);
+    connect(layer.painter.get(), &NanoShapePainter::pendingImageReady, this, [this, name] {
+        markLayerDirty(name);
+    });
+}
+
+QStringList NanoShape::layers() const
+{
+    QStringList names;
+    for (size_t i = 1; i < m_layers.size(); ++i) {
+        names += m_layers[i].name;
+    }
+    return names;
+}
+
+void NanoShape::setLayers(const QStringList& layers)
+{
+    if (this->layers() == layers) return;
+
+    m_layers.resize(1);
+    for (auto& name : layers) {
+        addLayer(name);
+    }
+
+    m_layersChanged = true;
+    markDirty();
+    emit layersChanged();
+}
+
+bool NanoShape::isRenderNodeEnabled() const
+{
+    return m_renderNodeEnabled;
+}
+
+void NanoShape::setRenderNodeEnabled(bool enabled)
+{
+    if (m_renderNodeEnabled == enabled) return;
+    m_renderNodeEnabled = enabled;
+
+    for (auto& layer : m_layers) {
+        layer.painter->setRenderNodeEnabled(enabled);
+    }
+
+    markDirty();
+    emit renderNodeEnabledChanged();
+}
+
+bool NanoShape::isParallelTessellationEnabled() const
+{
+    return m_parallelTessellationEnabled;
+}
+
+void NanoShape::setParallelTessellationEnabled(bool enabled)
+{
+    if (m_parallelTessellationEnabled == enabled) return;
+    m_parallelTessellationEnabled = enabled;
+
+    for (auto& layer : m_layers) {
+        layer.painter->setParallelTessellationEnabled(enabled);
+    }
+
+    emit parallelTessellationEnabledChanged();
+}
+
+bool NanoShape::isCulling() const
+{
+    return m_culling;
+}
+
+void NanoShape::setCulling(bool enabled)
+{
+    if (m_culling == enabled) return;
+    m_culling = enabled;
+    markDirty();
+    emit cullingChanged();
+}
+
+bool NanoShape::isHitTestEnabled() const
+{
+    return m_hitTestEnabled;
+}
+
+void NanoShape::setHitTestEnabled(bool enabled)
+{
+    if (m_hitTestEnabled == enabled) return;
+    m_hitTestEnabled = enabled;
+
+    for (auto& layer : m_layers) {
+        layer.painter->setHitTestEnabled(enabled);
+    }
+
+    markDirty();
+    emit hitTestEnabledChanged();
+}
+
+QString NanoShape::pathAt(qreal x, qreal y) const
+{
+    // the last layer is on top
+    for (auto it = m_layers.rbegin(); it != m_layers.rend(); ++it) {
+        auto name = it->painter->pathAt(QPointF(x, y));
+        if (!name.isEmpty()) return name;
+    }
+    return {};
+}
+
+QStringList NanoShape::pathsIn(qreal x, qreal y, qreal width, qreal height) const
+{
+    QStringList names;
+    for (auto& layer : m_layers) {
+        for (auto& name : layer.painter->pathsIn(QRectF(x, y, width, height))) {
+            if (!names.contains(name)) names += name;
+        }
+    }
+    return names;
+}
+
 void NanoShape::markDirty()
 {
-    m_dirty = true;
+    for (auto& layer : m_layers) {
+        layer.dirty = true;
+    }
     update();
 }
 
+void NanoShape::markLayerDirty(const QString& name)
+{
+    for (auto& layer : m_layers) {
+        if (layer.name == name) {
+            layer.dirty = true;
+            update();
+            return;
+        }
+    }
+}
+
 void NanoShape::geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry)
 {
     QQuickItem::geometryChange(newGeometry, oldGeometry);
@@ -354,10 +917,20 @@ void NanoShape::itemChange(QQuickItem::ItemChange change, const QQuickItem::Item
         if (data.window) {
             connect(data.window, &QQuickWindow::afterAnimating, this, &NanoShape::prepare);
         }
+        trackPixelRatio();
+        m_pixelRatioDirty = true;
+        markDirty();
+        break;
+    case ItemParentHasChanged:
+        trackPixelRatio();
+        m_pixelRatioDirty = true;
         markDirty();
         break;
-    case ItemAntialiasingHasChanged:
     case ItemDevicePixelRatioHasChanged:
+        m_pixelRatioDirty = true;
+        markDirty();
+        break;
+    case ItemAntialiasingHasChanged:
         markDirty();
         break;
     default:
@@ -367,21 +940,153 @@ void NanoShape::itemChange(QQuickItem::ItemChange change, const QQuickItem::Item
     QQuickItem::itemChange(change, data);
 }
 
+void NanoShape::trackPixelRatio()
+{
+    for (auto& connection : m_pixelRatioConnections) {
+        disconnect(connection);
+    }
+    m_pixelRatioConnections.clear();
+    m_parentScales.clear();
+
+    // the pixel ratio includes scale of all the parents, the chain is tracked again if it is changed
+    for (auto item = parentItem(); item; item = item->parentItem()) {
+        auto index = m_parentScales.size();
+        m_parentScales.push_back(item->scale());
+        m_pixelRatioConnections.push_back(connect(item, &QQuickItem::scaleChanged, this, [this, item, index] {
+            m_parentScales[index] = item->scale();
+            m_parentScale = std::accumulate(m_parentScales.begin(), m_parentScales.end(), qreal(1), std::multiplies<qreal>());
+            updatePixelRatio();
+        }));
+        m_pixelRatioConnections.push_back(connect(item, &QQuickItem::parentChanged, this, [this] {
+            trackPixelRatio();
+            updatePixelRatio();
+        }));
+    }
+    m_pixelRatioConnections.push_back(connect(this, &QQuickItem::scaleChanged, this, &NanoShape::updatePixelRatio));
+    m_parentScale = std::accumulate(m_parentScales.begin(), m_parentScales.end(), qreal(1), std::multiplies<qreal>());
+}
+
+// same as NanoPainter::itemPixelRatio, but with the tracked scale of the parents
+float NanoShape::currentPixelRatio() const
+{
+    if (!window()) return 1;
+    return qMax(0.5, window()->effectiveDevicePixelRatio() * scale() * m_parentScale);
+}
+
+void NanoShape::updatePixelRatio()
+{
+    auto ratio = currentPixelRatio();
+    if (qFuzzyCompare(m_itemPixelRatio, ratio)) {
+        m_pixelRatioTimer.stop();
+        return;
+    }
+
+    // the geometry is scaled by scene graph, it is tessellated again only if the bucket is changed,
+    // and with the exact ratio once the scale stops changing
+    auto bucket = NanoPainter::itemPixelRatioBucket(ratio);
+    if (!qFuzzyCompare(NanoPainter::itemPixelRatioBucket(m_itemPixelRatio), bucket)) {
+        setPixelRatio(bucket);
+    }
+    m_pixelRatioTimer.start();
+}
+
+void NanoShape::setPixelRatio(float ratio)
+{
+    if (qFuzzyCompare(m_itemPixelRatio, ratio)) return;
+    m_itemPixelRatio = ratio;
+
+    for (auto& layer : m_layers) {
+        layer.painter->setItemPixelRatio(ratio);
+    }
+    markDirty();
+}
+
 void NanoShape::prepare()
 {
-    if (!m_dirty) return;
-    m_painter.reset();
-    emit paint(&m_painter);
+    if (m_pixelRatioDirty) {
+        m_pixelRatioDirty = false;
+        m_pixelRatioTimer.stop();
+
+        // the item created with parent has no parent change, so the chain may not be tracked yet
+        if (m_pixelRatioConnections.empty()) trackPixelRatio();
+        setPixelRatio(currentPixelRatio());
+    }
+
+    QRectF visibleRect;
+    QRectF cullRect;
+
+    if (m_culling) {
+        visibleRect = NanoPainter::itemVisibleRect(this);
+
+        // paint a bit more than visible, so it is not painted again on every scrolling step
+        cullRect = visibleRect;
+        if (cullRect.isValid()) {
+            auto dx = cullRect.width() / 4;
+            auto dy = cullRect.height() / 4;
+            cullRect.adjust(-dx, -dy, dx, dy);
+        }
+    }
+
+    for (auto& layer : m_layers) {
+        // something was culled, and now it may become visible
+        if (m_culling && !layer.dirty && visibleRect.isValid() && !layer.cullRect.contains(visibleRect)
+            && layer.painter->statistics().culledCalls > 0) {
+            layer.dirty = true;
+            update();
+        }
+
+        if (!layer.dirty) continue;
+        layer.dirty = false;
+        layer.recorded = true;
+        layer.cullRect = cullRect;
+
+        auto painter = layer.painter.get();
+        painter->reset();
+        painter->setVisibleRect(cullRect);
+        painter->clearPendingImages();
+
+        if (layer.name.isEmpty()) {
+            emit paint(painter);
+        } else {
+            emit paintLayer(layer.name, painter);
+        }
+    }
 }
 
 QSGNode* NanoShape::updatePaintNode(QSGNode* node, QQuickItem::UpdatePaintNodeData*)
 {
-    if (!qFuzzyCompare(m_itemPixelRatio, m_painter.itemPixelRatio())) {
-        m_itemPixelRatio = m_painter.itemPixelRatio();
-        m_dirty = true;
+    // each layer has its own sub-tree under the root node, in the same order
+    if (node && m_layersChanged) {
+        while (auto child = node->firstChild()) {
+            node->removeChildNode(child);
+            delete child;
+        }
+    }
+
+    if (!node) node = new QSGNode();
+    if (!node->firstChild()) {
+        bool repaint = false;
+        for (auto& layer : m_layers) {
+            node->appendChildNode(new QSGNode());
+
+            // the old sub-tree is gone, the layer must be painted again
+            if (!layer.recorded) {
+                layer.dirty = true;
+                repaint = true;
+            }
+        }
+        if (repaint) QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+    }
+    m_layersChanged = false;
+
+    auto child = node->firstChild();
+    for (auto& layer : m_layers) {
+        if (layer.recorded) {
+            layer.recorded = false;
+            layer.painter->updatePaintNode(child);
+        }
+        child = child->nextSibling();
     }
 
-    if (node && !m_dirty) return node;
-    m_dirty = false;
-    return m_painter.updatePaintNode(node);
+    return node;
 }
@@ -0,0 +1,319 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#include "NanoTiledShape.h"
+
+#include <QQuickWindow>
+#include <QSGClipNode>
+#include <QtMath>
+
+#include <algorithm>
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+#define geometryChange geometryChanged
+#endif
+
+//---------------------------------------------------------------------------
+
+static const int MIN_TILE_LEVEL = -16;
+static const int MAX_TILE_LEVEL = 16;
+
+// the approximate size of the vertex data of each triangle
+static const int TRIANGLE_COST = 3 * 4 * sizeof(float);
+
+static inline qint64 tileKey(int level, int row, int column)
+{
+    return qint64(level - MIN_TILE_LEVEL) << 48 | qint64(row) << 24 | qint64(column);
+}
+
+// the tile is clipped by scissor of the scene graph, so the adjacent tiles have no seam
+class NanoTileNode : public QSGClipNode
+{
+public:
+    explicit NanoTileNode(const QRectF& rect)
+        : m_geometry(QSGGeometry::defaultAttributes_Point2D(), 4)
+    {
+        setGeometry(&m_geometry);
+        setIsRectangular(true);
+        setRect(rect);
+    }
+
+    void setRect(const QRectF& rect)
+    {
+        if (clipRect() == rect) return;
+        QSGGeometry::updateRectGeometry(&m_geometry, rect);
+        setClipRect(rect);
+        markDirty(DirtyGeometry);
+    }
+
+    bool isHidden() const { return m_hidden; }
+
+    void setHidden(bool hidden)
+    {
+        if (m_hidden == hidden) return;
+        m_hidden = hidden;
+        markDirty(DirtySubtreeBlocked);
+    }
+
+    virtual bool isSubtreeBlocked() const override
+    {
+        return m_hidden;
+    }
+
+    int cost = 0;
+
+private:
+    QSGGeometry m_geometry;
+    bool m_hidden = false;
+};
+
+//---------------------------------------------------------------------------
+
+NanoTiledShape::NanoTiledShape(QQuickItem* parent)
+    : QQuickItem(parent)
+{
+    setFlag(ItemHasContents);
+    setAntialiasing(true);
+}
+
+NanoTiledShape::~NanoTiledShape()
+{
+    // do nothing
+}
+
+qreal NanoTiledShape::tileSize() const
+{
+    return m_tileSize;
+}
+
+void NanoTiledShape::setTileSize(qreal size)
+{
+    size = qMax(size, 16.0);
+    if (qFuzzyCompare(m_tileSize, size)) return;
+    m_tileSize = size;
+
+    // all the tile rects are changed
+    markDirty();
+    emit tileSizeChanged();
+}
+
+int NanoTiledShape::cacheLimit() const
+{
+    return m_cacheLimit;
+}
+
+void NanoTiledShape::setCacheLimit(int bytes)
+{
+    if (m_cacheLimit == bytes) return;
+    m_cacheLimit = bytes;
+    update();
+    emit cacheLimitChanged();
+}
+
+void NanoTiledShape::markDirty()
+{
+    for (auto& [key, tile] : m_tiles) {
+        tile.dirty = true;
+    }
+    update();
+}
+
+void NanoTiledShape::markRectDirty(qreal x, qreal y, qreal width, qreal height)
+{
+    QRectF rect(x, y, width, height);
+    for (auto& [key, tile] : m_tiles) {
+        if (tileRect(key).intersects(rect)) tile.dirty = true;
+    }
+    update();
+}
+
+QRectF NanoTiledShape::tileRect(qint64 key) const
+{
+    auto level = int(key >> 48) + MIN_TILE_LEVEL;
+    auto row = int((key >> 24) & 0xffffff);
+    auto column = int(key & 0xffffff);
+    auto size = m_tileSize / qPow(2, level);
+    return QRectF(column * size, row * size, size, size);
+}
+
+void NanoTiledShape::geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) markDirty();
+}
+
+void NanoTiledShape::itemChange(QQuickItem::ItemChange change, const QQuickItem::ItemChangeData& data)
+{
+    switch (change) {
+    case ItemSceneChange:
+        if (window()) {
+            disconnect(window(), &QQuickWindow::afterAnimating, this, &NanoTiledShape::prepare);
+        }
+        if (data.window) {
+            connect(data.window, &QQuickWindow::afterAnimating, this, &NanoTiledShape::prepare);
+        }
+        markDirty();
+        break;
+    case ItemAntialiasingHasChanged:
+    case ItemDevicePixelRatioHasChanged:
+        markDirty();
+        break;
+    default:
+        break;
+    }
+
+    QQuickItem::itemChange(change, data);
+}
+
+void NanoTiledShape::prepare()
+{
+    if (!window() || width() <= 0 || height() <= 0) return;
+    ++m_frame;
+
+    // the tile level follows the zoom level, so the visible tiles are about the same number
+    auto ratio = NanoPainter::itemPixelRatio(this) / window()->effectiveDevicePixelRatio();
+    auto level = std::clamp(qRound(std::log2(ratio)), MIN_TILE_LEVEL, MAX_TILE_LEVEL);
+    auto size = m_tileSize / qPow(2, level);
+
+    auto visibleRect = NanoPainter::itemVisibleRect(this) & QRectF(0, 0, width(), height());
+    std::vector<qint64> visibleTiles;
+
+    if (!visibleRect.isEmpty()) {
+        auto column0 = qMax(0, int(visibleRect.left() / size));
+        auto row0 = qMax(0, int(visibleRect.top() / size));
+        auto column1 = qMin(0xffffff, int(std::ceil(visibleRect.right() / size)) - 1);
+        auto row1 = qMin(0xffffff, int(std::ceil(visibleRect.bottom() / size)) - 1);
+
+        for (int row = row0; row <= row1; ++row) {
+            for (int column = column0; column <= column1; ++column) {
+                auto key = tileKey(level, row, column);
+                auto& tile = m_tiles[key];
+                tile.lastVisible = m_frame;
+                visibleTiles.push_back(key);
+                if (tile.painted && !tile.dirty) continue;
+
+                NanoShapePainter* painter;
+                if (m_freePainters.empty()) {
+                    painter = m_painters.emplace_back(new NanoShapePainter(this)).get();
+                    connect(painter, &NanoShapePainter::pendingImageReady, this, &NanoTiledShape::markDirty);
+                } else {
+                    painter = m_freePainters.back();
+                    m_freePainters.pop_back();
+                }
+
+                // tessellated for the level, the geometry is scaled by scene graph within the level
+                auto rect = tileRect(key);
+                painter->setItemPixelRatio(float(qPow(2, level) * window()->effectiveDevicePixelRatio()));
+                painter->reset();
+                painter->clearPendingImages();
+                painter->setVisibleRect(rect);
+                emit paintTile(painter, rect);
+
+                m_pendingTiles.push_back({ key, painter });
+                tile.dirty = false;
+                tile.painted = true;
+            }
+        }
+    }
+
+    if (!m_pendingTiles.empty() || visibleTiles != m_visibleTiles) update();
+    m_visibleTiles = std::move(visibleTiles);
+}
+
+QSGNode* NanoTiledShape::updatePaintNode(QSGNode* node, QQuickItem::UpdatePaintNodeData*)
+{
+    if (!node) {
+        node = new QSGNode();
+
+        // the old tree is gone with all the tile nodes, the tiles must be painted again
+        for (auto& [key, tile] : m_tiles) {
+            tile.node = nullptr;
+            tile.painted = false;
+        }
+        for (auto& pending : m_pendingTiles) {
+            m_tiles[pending.key].painted = true;
+        }
+    }
+
+    for (auto& pending : m_pendingTiles) {
+        auto& tile = m_tiles[pending.key];
+        if (!tile.node) {
+            tile.node = new NanoTileNode(tileRect(pending.key));
+            node->appendChildNode(tile.node);
+        } else {
+            tile.node->setRect(tileRect(pending.key));
+        }
+
+        pending.painter->updatePaintNode(tile.node);
+        tile.node->cost = pending.painter->statistics().triangles * TRIANGLE_COST;
+        m_freePainters.push_back(pending.painter);
+    }
+    m_pendingTiles.clear();
+
+    // the hidden tiles are kept for later, the least recently visible ones are removed first
+    std::vector<std::pair<quint64, qint64>> hiddenTiles;
+    std::vector<qint64> removedTiles;
+    qint64 hiddenCost = 0;
+    bool repaint = false;
+
+    for (auto& [key, tile] : m_tiles) {
+        auto visible = tile.lastVisible == m_frame;
+        if (!tile.node) {
+            if (visible && !tile.painted) repaint = true;
+            if (!visible) removedTiles.push_back(key);
+            continue;
+        }
+
+        tile.node->setHidden(!visible);
+        if (visible) continue;
+
+        if (tile.dirty) {
+            removedTiles.push_back(key);
+        } else {
+            hiddenTiles.emplace_back(tile.lastVisible, key);
+            hiddenCost += tile.node->cost;
+        }
+    }
+
+    std::sort(hiddenTiles.begin(), hiddenTiles.end());
+    for (auto& [lastVisible, key] : hiddenTiles) {
+        if (hiddenCost <= m_cacheLimit) break;
+        hiddenCost -= m_tiles[key].node->cost;
+        removedTiles.push_back(key);
+    }
+
+    for (auto key : removedTiles) {
+        auto& tile = m_tiles[key];
+        if (tile.node) {
+            node->removeChildNode(tile.node);
+            delete tile.node;
+        }
+        m_tiles.erase(key);
+    }
+
+    if (repaint) QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+    return node;
+}
@@ -0,0 +1,370 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+// benchmark of the join calculation of nanovg stroke, the scalar loop of nvg__calculateJoins against
+// the 4-wide SSE2 (or NEON on arm64) kernel of nvg__calculateJoins4, on the same array-of-structs points.
+// the output of both must be bit-identical, then the time of both is reported.
+// it is not a test, run it by hand to repeat the comparison.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BENCH_SSE2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define BENCH_NEON 1
+#endif
+
+//---------------------------------------------------------------------------
+
+// same as nanovg.c
+enum NVGpointFlags
+{
+    NVG_PT_CORNER = 0x01,
+    NVG_PT_LEFT = 0x02,
+    NVG_PT_BEVEL = 0x04,
+    NVG_PR_INNERBEVEL = 0x08,
+};
+
+enum NVGlineJoin
+{
+    NVG_ROUND = 1,
+    NVG_BEVEL = 3,
+    NVG_MITER = 4,
+};
+
+struct NVGpoint
+{
+    float x, y;
+    float dx, dy;
+    float len;
+    float dmx, dmy;
+    unsigned char flags;
+};
+
+struct JoinResult
+{
+    int nbevel = 0;
+    int nleft = 0;
+};
+
+//---------------------------------------------------------------------------
+
+// the inner loop of nvg__calculateJoins for one path
+static JoinResult scalarJoins(NVGpoint* pts, int count, float iw, int lineJoin, float miterLimit)
+{
+    JoinResult r;
+    NVGpoint* p0 = &pts[count - 1];
+    NVGpoint* p1 = &pts[0];
+
+    for (int j = 0; j < count; j++) {
+        float dlx0 = p0->dy;
+        float dly0 = -p0->dx;
+        float dlx1 = p1->dy;
+        float dly1 = -p1->dx;
+        p1->dmx = (dlx0 + dlx1) * 0.5f;
+        p1->dmy = (dly0 + dly1) * 0.5f;
+        float dmr2 = p1->dmx * p1->dmx + p1->dmy * p1->dmy;
+        if (dmr2 > 0.000001f) {
+            float scale = 1.0f / dmr2;
+            if (scale > 600.0f) scale = 600.0f;
+            p1->dmx *= scale;
+            p1->dmy *= scale;
+        }
+
+        p1->flags = (p1->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
+
+        float cross = p1->dx * p0->dy - p0->dx * p1->dy;
+        if (cross > 0.0f) {
+            r.nleft++;
+            p1->flags |= NVG_PT_LEFT;
+        }
+
+        float limit = std::max(1.01f, std::min(p0->len, p1->len) * iw);
+        if ((dmr2 * limit * limit) < 1.0f) p1->flags |= NVG_PR_INNERBEVEL;
+
+        if (p1->flags & NVG_PT_CORNER) {
+            if ((dmr2 * miterLimit * miterLimit) < 1.0f || lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND) {
+                p1->flags |= NVG_PT_BEVEL;
+            }
+        }
+
+        if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0) r.nbevel++;
+        p0 = p1++;
+    }
+
+    return r;
+}
+
+// one point of the loop above, p1 only writes dmx, dmy and flags and p0 only reads dx, dy and len,
+// so the points can be done in any order
+static void scalarJoin(NVGpoint* pts, int prev, int j, float iw, bool forceBevel, float miterLimit, JoinResult& r)
+{
+    auto p0 = &pts[prev];
+    auto p1 = &pts[j];
+    float dmx = (p0->dy + p1->dy) * 0.5f;
+    float dmy = (-p0->dx + -p1->dx) * 0.5f;
+    float dmr2 = dmx * dmx + dmy * dmy;
+    if (dmr2 > 0.000001f) {
+        float scale = std::min(1.0f / dmr2, 600.0f);
+        dmx *= scale;
+        dmy *= scale;
+    }
+    p1->dmx = dmx;
+    p1->dmy = dmy;
+
+    auto flags = p1->flags & NVG_PT_CORNER;
+    if (p1->dx * p0->dy - p0->dx * p1->dy > 0.0f) {
+        r.nleft++;
+        flags |= NVG_PT_LEFT;
+    }
+
+    float limit = std::max(1.01f, std::min(p0->len, p1->len) * iw);
+    if ((dmr2 * limit * limit) < 1.0f) flags |= NVG_PR_INNERBEVEL;
+    if ((flags & NVG_PT_CORNER) && ((dmr2 * miterLimit * miterLimit) < 1.0f || forceBevel)) flags |= NVG_PT_BEVEL;
+    if (flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) r.nbevel++;
+    p1->flags = (unsigned char)flags;
+}
+
+#if BENCH_SSE2 || BENCH_NEON
+
+// the 4 points from pts[j] are transposed into registers, and the results are scattered back per point
+static JoinResult simdJoins(NVGpoint* pts, int count, float iw, int lineJoin, float miterLimit)
+{
+    JoinResult r;
+    bool forceBevel = lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND;
+    if (count <= 0) return r;
+
+    scalarJoin(pts, count - 1, 0, iw, forceBevel, miterLimit, r);
+
+    int j = 1;
+    alignas(16) float dmxOut[4], dmyOut[4];
+
+    for (; j + 4 <= count; j += 4) {
+        auto a = &pts[j - 1];
+        auto b = &pts[j];
+
+#if BENCH_SSE2
+        auto dx0 = _mm_setr_ps(a[0].dx, a[1].dx, a[2].dx, a[3].dx);
+        auto dy0 = _mm_setr_ps(a[0].dy, a[1].dy, a[2].dy, a[3].dy);
+        auto len0 = _mm_setr_ps(a[0].len, a[1].len, a[2].len, a[3].len);
+        auto dx1 = _mm_setr_ps(b[0].dx, b[1].dx, b[2].dx, b[3].dx);
+        auto dy1 = _mm_setr_ps(b[0].dy, b[1].dy, b[2].dy, b[3].dy);
+        auto len1 = _mm_setr_ps(b[0].len, b[1].len, b[2].len, b[3].len);
+
+        auto sign = _mm_set1_ps(-0.0f);
+        auto half = _mm_set1_ps(0.5f);
+        auto dmx = _mm_mul_ps(_mm_add_ps(dy0, dy1), half);
+        auto dmy = _mm_mul_ps(_mm_add_ps(_mm_xor_ps(dx0, sign), _mm_xor_ps(dx1, sign)), half);
+        auto dmr2 = _mm_add_ps(_mm_mul_ps(dmx, dmx), _mm_mul_ps(dmy, dmy));
+
+        auto big = _mm_cmpgt_ps(dmr2, _mm_set1_ps(0.000001f));
+        auto scale = _mm_min_ps(_mm_div_ps(_mm_set1_ps(1.0f), dmr2), _mm_set1_ps(600.0f));
+        dmx = _mm_or_ps(_mm_and_ps(big, _mm_mul_ps(dmx, scale)), _mm_andnot_ps(big, dmx));
+        dmy = _mm_or_ps(_mm_and_ps(big, _mm_mul_ps(dmy, scale)), _mm_andnot_ps(big, dmy));
+
+        auto cross = _mm_sub_ps(_mm_mul_ps(dx1, dy0), _mm_mul_ps(dx0, dy1));
+        auto left = _mm_movemask_ps(_mm_cmpgt_ps(cross, _mm_setzero_ps()));
+
+        auto limit = _mm_max_ps(_mm_set1_ps(1.01f), _mm_mul_ps(_mm_min_ps(len0, len1), _mm_set1_ps(iw)));
+        auto inner = _mm_movemask_ps(_mm_cmplt_ps(_mm_mul_ps(_mm_mul_ps(dmr2, limit), limit), _mm_set1_ps(1.0f)));
+        auto miter = _mm_set1_ps(miterLimit);
+        auto bevel = _mm_movemask_ps(_mm_cmplt_ps(_mm_mul_ps(_mm_mul_ps(dmr2, miter), miter), _mm_set1_ps(1.0f)));
+
+        _mm_store_ps(dmxOut, dmx);
+        _mm_store_ps(dmyOut, dmy);
+#else
+        float t[4];
+        auto load = [&](const NVGpoint* p, float NVGpoint::*field) {
+            t[0] = p[0].*field; t[1] = p[1].*field; t[2] = p[2].*field; t[3] = p[3].*field;
+            return vld1q_f32(t);
+        };
+        auto dx0 = load(a, &NVGpoint::dx);
+        auto dy0 = load(a, &NVGpoint::dy);
+        auto len0 = load(a, &NVGpoint::len);
+        auto dx1 = load(b, &NVGpoint::dx);
+        auto dy1 = load(b, &NVGpoint::dy);
+        auto len1 = load(b, &NVGpoint::len);
+
+        auto half = vdupq_n_f32(0.5f);
+        auto dmx = vmulq_f32(vaddq_f32(dy0, dy1), half);
+        auto dmy = vmulq_f32(vaddq_f32(vnegq_f32(dx0), vnegq_f32(dx1)), half);
+        auto dmr2 = vaddq_f32(vmulq_f32(dmx, dmx), vmulq_f32(dmy, dmy));
+
+        auto big = vcgtq_f32(dmr2, vdupq_n_f32(0.000001f));
+        auto scale = vminq_f32(vdivq_f32(vdupq_n_f32(1.0f), dmr2), vdupq_n_f32(600.0f));
+        dmx = vbslq_f32(big, vmulq_f32(dmx, scale), dmx);
+        dmy = vbslq_f32(big, vmulq_f32(dmy, scale), dmy);
+
+        auto bits = [](uint32x4_t m) {
+            static const uint32x4_t lanes = { 1, 2, 4, 8 };
+            return int(vaddvq_u32(vandq_u32(m, lanes)));
+        };
+        auto cross = vsubq_f32(vmulq_f32(dx1, dy0), vmulq_f32(dx0, dy1));
+        auto left = bits(vcgtq_f32(cross, vdupq_n_f32(0.0f)));
+
+        auto limit = vmaxq_f32(vdupq_n_f32(1.01f), vmulq_f32(vminq_f32(len0, len1), vdupq_n_f32(iw)));
+        auto inner = bits(vcltq_f32(vmulq_f32(vmulq_f32(dmr2, limit), limit), vdupq_n_f32(1.0f)));
+        auto miter = vdupq_n_f32(miterLimit);
+        auto bevel = bits(vcltq_f32(vmulq_f32(vmulq_f32(dmr2, miter), miter), vdupq_n_f32(1.0f)));
+
+        vst1q_f32(dmxOut, dmx);
+        vst1q_f32(dmyOut, dmy);
+#endif
+
+        if (forceBevel) bevel = 0xf;
+
+        for (int k = 0; k < 4; ++k) {
+            auto p = &b[k];
+            p->dmx = dmxOut[k];
+            p->dmy = dmyOut[k];
+
+            auto flags = p->flags & NVG_PT_CORNER;
+            if (left & (1 << k)) {
+                r.nleft++;
+                flags |= NVG_PT_LEFT;
+            }
+            if (inner & (1 << k)) flags |= NVG_PR_INNERBEVEL;
+            if ((flags & NVG_PT_CORNER) && (bevel & (1 << k))) flags |= NVG_PT_BEVEL;
+            p->flags = (unsigned char)flags;
+            if (flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) r.nbevel++;
+        }
+    }
+
+    for (; j < count; ++j) {
+        scalarJoin(pts, j - 1, j, iw, forceBevel, miterLimit, r);
+    }
+
+    return r;
+}
+
+#endif
+
+//---------------------------------------------------------------------------
+
+// random polyline with the direction and length to the next point, like nvg__flattenPaths
+static std::vector<NVGpoint> randomPolyline(int count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> step(-20, 20);
+    std::uniform_int_distribution<int> corner(0, 7);
+    std::vector<NVGpoint> pts(count);
+
+    float x = 0, y = 0;
+    for (auto& p : pts) {
+        p = {};
+        p.x = x;
+        p.y = y;
+        p.flags = corner(rng) ? NVG_PT_CORNER : 0;
+        x += step(rng);
+        y += step(rng);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        auto& p0 = pts[i];
+        auto& p1 = pts[(i + 1) % count];
+        p0.dx = p1.x - p0.x;
+        p0.dy = p1.y - p0.y;
+        p0.len = std::sqrt(p0.dx * p0.dx + p0.dy * p0.dy);
+        if (p0.len > 1e-6f) {
+            p0.dx /= p0.len;
+            p0.dy /= p0.len;
+        }
+    }
+
+    return pts;
+}
+
+static bool samePoints(const std::vector<NVGpoint>& a, const std::vector<NVGpoint>& b)
+{
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (memcmp(&a[i].dmx, &b[i].dmx, sizeof(float)) != 0 || memcmp(&a[i].dmy, &b[i].dmy, sizeof(float)) != 0
+                || a[i].flags != b[i].flags) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Kernel>
+static double bestTime(std::vector<NVGpoint>& pts, int repeat, Kernel kernel)
+{
+    auto best = 1e30;
+    for (int run = 0; run < 5; ++run) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeat; ++i) {
+            kernel(pts);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / (double(repeat) * pts.size()));
+    }
+    return best;
+}
+
+int main()
+{
+#if BENCH_SSE2 || BENCH_NEON
+    static const char* simdName = BENCH_SSE2 ? "sse2" : "neon";
+    std::mt19937 rng(48);
+    bool ok = true;
+
+    for (int lineJoin : { NVG_MITER, NVG_BEVEL, NVG_ROUND }) {
+        for (int count : { 2000, 100000 }) {
+            auto source = randomPolyline(count, rng);
+            auto scalar = source;
+            auto simd = source;
+            float iw = 1.0f / 3.0f;
+            float miterLimit = 4;
+
+            auto r0 = scalarJoins(scalar.data(), count, iw, lineJoin, miterLimit);
+            auto r1 = simdJoins(simd.data(), count, iw, lineJoin, miterLimit);
+            if (r0.nbevel != r1.nbevel || r0.nleft != r1.nleft || !samePoints(scalar, simd)) {
+                printf("FAIL: %s joins are different from scalar joins (join %d, %d points)\n", simdName, lineJoin, count);
+                ok = false;
+                continue;
+            }
+
+            auto repeat = std::max(1, 2000000 / count);
+            volatile int sink = 0;
+            auto ts = bestTime(scalar, repeat, [&](std::vector<NVGpoint>& p) { sink += scalarJoins(p.data(), count, iw, lineJoin, miterLimit).nbevel; });
+            auto tv = bestTime(simd, repeat, [&](std::vector<NVGpoint>& p) { sink += simdJoins(p.data(), count, iw, lineJoin, miterLimit).nbevel; });
+            printf("join %d, %6d points: scalar %.2f ns/point, %s %.2f ns/point\n", lineJoin, count, ts, simdName, tv);
+        }
+    }
+
+    return ok ? 0 : 1;
+#else
+    printf("no sse2 or neon, nothing to compare\n");
+    return 0;
+#endif
+}
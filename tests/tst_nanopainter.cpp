@@ -0,0 +1,203 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+// the parallel tessellation of NanoPainter must emit the same nodes in the same order as serial tessellation,
+// even if it is switched on or off in the middle of painting, and the hit test must keep the paint order too.
+
+#include "NanoMaterial.h"
+#include "NanoPainter.h"
+
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QSGGeometryNode>
+#include <QtTest>
+
+//---------------------------------------------------------------------------
+
+class tst_NanoPainter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Mode
+    {
+        Serial,
+        Parallel,
+        ParallelOff,
+        ParallelOn,
+    };
+    Q_ENUM(Mode)
+
+private slots:
+    void paintOrder_data();
+    void paintOrder();
+    void hitOrder_data();
+    void hitOrder();
+};
+
+// more than a few batches, and switched in the middle of one
+static constexpr int PATH_COUNT = 200;
+static constexpr int SWITCH_AT = 100;
+
+struct PaintResult
+{
+    QStringList names;
+    QList<QByteArray> vertices;
+    QStringList hits;
+};
+
+// each node is compared by its material name and its vertices
+static void collectNodes(QSGNode* root, PaintResult& result)
+{
+    for (auto child = root ? root->firstChild() : nullptr; child; child = child->nextSibling()) {
+        QCOMPARE(child->type(), QSGNode::GeometryNodeType);
+        auto node = static_cast<QSGGeometryNode*>(child);
+        auto geo = node->geometry();
+        result.names += static_cast<NanoMaterial*>(node->material())->name();
+        result.vertices += QByteArray(static_cast<const char*>(geo->vertexData()), geo->vertexCount() * geo->sizeOfVertex());
+    }
+}
+
+// a fresh window for each paint, so the pooled geometry of last paint does not change the capacity
+static PaintResult paint(tst_NanoPainter::Mode mode, bool deferred)
+{
+    QQuickWindow window;
+    QQuickItem item(window.contentItem());
+    item.setSize(QSizeF(200, 200));
+
+    auto painter = deferred ? new NanoPainter(&item, 1) : new NanoPainter(&item, nullptr, 1);
+    painter->setHitTestEnabled(true);
+    painter->setParallelTessellationEnabled(mode == tst_NanoPainter::Parallel || mode == tst_NanoPainter::ParallelOff);
+
+    for (int i = 0; i < PATH_COUNT; ++i) {
+        if (i == SWITCH_AT && mode == tst_NanoPainter::ParallelOff) painter->setParallelTessellationEnabled(false);
+        if (i == SWITCH_AT && mode == tst_NanoPainter::ParallelOn) painter->setParallelTessellationEnabled(true);
+
+        // the neighbours overlap, so the hit test depends on the paint order
+        painter->beginPath(QStringLiteral("path%1").arg(i));
+        painter->addRect(float(i % 20) * 8, float(i / 20) * 8, 12, 12);
+        painter->setFillBrush(QColor::fromHsv(i % 360, 255, 255));
+        painter->fill();
+        painter->setStrokeBrush(QColor::fromHsv((i * 7) % 360, 255, 128));
+        painter->setStrokeWidth(1 + i % 3);
+        painter->stroke();
+    }
+
+    PaintResult result;
+    auto root = painter->updatePaintNode(nullptr);
+    collectNodes(root, result);
+
+    for (int y = 0; y < 200; y += 3) {
+        for (int x = 0; x < 200; x += 3) {
+            result.hits += painter->pathAt(QPointF(x + 0.5, y + 0.5));
+        }
+    }
+
+    delete painter;
+    delete root;
+    return result;
+}
+
+void tst_NanoPainter::paintOrder_data()
+{
+    QTest::addColumn<Mode>("mode");
+    QTest::addColumn<bool>("deferred");
+
+    for (auto deferred : { true, false }) {
+        auto suffix = deferred ? " deferred" : "";
+        QTest::newRow(QByteArray("parallel") + suffix) << Parallel << deferred;
+        QTest::newRow(QByteArray("parallel off") + suffix) << ParallelOff << deferred;
+        QTest::newRow(QByteArray("parallel on") + suffix) << ParallelOn << deferred;
+    }
+}
+
+void tst_NanoPainter::paintOrder()
+{
+    QFETCH(Mode, mode);
+    QFETCH(bool, deferred);
+
+    auto serial = paint(Serial, deferred);
+    auto result = paint(mode, deferred);
+
+    QCOMPARE(serial.names.size(), PATH_COUNT * 2);
+    QCOMPARE(result.names, serial.names);
+    QCOMPARE(result.vertices, serial.vertices);
+    QCOMPARE(result.hits, serial.hits);
+}
+
+void tst_NanoPainter::hitOrder_data()
+{
+    QTest::addColumn<bool>("parallelFirst");
+    QTest::addColumn<bool>("deferred");
+
+    QTest::newRow("parallel then serial deferred") << true << true;
+    QTest::newRow("parallel then serial") << true << false;
+    QTest::newRow("serial then parallel deferred") << false << true;
+    QTest::newRow("serial then parallel") << false << false;
+}
+
+void tst_NanoPainter::hitOrder()
+{
+    QFETCH(bool, parallelFirst);
+    QFETCH(bool, deferred);
+
+    QQuickWindow window;
+    QQuickItem item(window.contentItem());
+    item.setSize(QSizeF(200, 200));
+
+    auto painter = deferred ? new NanoPainter(&item, 1) : new NanoPainter(&item, nullptr, 1);
+    painter->setHitTestEnabled(true);
+    painter->setParallelTessellationEnabled(parallelFirst);
+
+    // the last painted path is on top, no matter which way it is tessellated
+    for (int i = 0; i < PATH_COUNT; ++i) {
+        painter->beginPath(QStringLiteral("below%1").arg(i));
+        painter->addRect(50, 50, 100, 100);
+        painter->fill();
+    }
+
+    painter->setParallelTessellationEnabled(!parallelFirst);
+    painter->beginPath(QStringLiteral("top"));
+    painter->addRect(50, 50, 100, 100);
+    painter->fill();
+
+    auto root = painter->updatePaintNode(nullptr);
+    QCOMPARE(painter->pathAt(QPointF(100, 100)), QStringLiteral("top"));
+    QCOMPARE(painter->pathsIn(QRectF(90, 90, 20, 20)).size(), PATH_COUNT + 1);
+
+    PaintResult result;
+    collectNodes(root, result);
+    QCOMPARE(result.names.size(), PATH_COUNT + 1);
+    QCOMPARE(result.names.constLast(), QStringLiteral("top_fill"));
+
+    delete painter;
+    delete root;
+}
+
+QTEST_MAIN(tst_NanoPainter)
+
+#include "tst_nanopainter.moc"
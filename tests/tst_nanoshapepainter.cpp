@@ -0,0 +1,118 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "NanoShape.h"
+
+#include <QJSEngine>
+#include <QQuickItem>
+#include <QtTest>
+
+#include <cmath>
+#include <limits>
+
+//---------------------------------------------------------------------------
+
+class tst_NanoShapePainter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void execute_data();
+    void execute();
+    void executeFloat64();
+};
+
+// the commands are passed as ArrayBuffer, which is read as Float32Array
+static QByteArray toBuffer(const QList<float>& commands)
+{
+    return QByteArray(reinterpret_cast<const char*>(commands.constData()), commands.size() * int(sizeof(float)));
+}
+
+void tst_NanoShapePainter::execute_data()
+{
+    using P = NanoShapePainter;
+    auto nan = std::numeric_limits<float>::quiet_NaN();
+    auto inf = std::numeric_limits<float>::infinity();
+
+    QTest::addColumn<QList<float>>("commands");
+    QTest::addColumn<bool>("result");
+
+    QTest::newRow("valid") << QList<float> { P::CommandBeginPath, P::CommandMoveTo, 0, 0, P::CommandLineTo, 10, 10, P::CommandStroke } << true;
+    QTest::newRow("polygon") << QList<float> { P::CommandAddPolygon, 3, 0, 0, 10, 0, 10, 10, P::CommandFill } << true;
+    QTest::newRow("truncated") << QList<float> { P::CommandMoveTo, 0 } << false;
+    QTest::newRow("polygon truncated") << QList<float> { P::CommandAddPolygon, 3, 0, 0, 10, 0 } << false;
+    QTest::newRow("polygon count overflow") << QList<float> { P::CommandAddPolygon, 1073741825.0f, 0, 0 } << false;
+    QTest::newRow("polygon count nan") << QList<float> { P::CommandAddPolygon, nan, 0, 0 } << false;
+    QTest::newRow("polygon count negative") << QList<float> { P::CommandAddPolygon, -1, 0, 0 } << false;
+    QTest::newRow("dash count oversized") << QList<float> { P::CommandSetDashPattern, 3, 1, 1 } << false;
+    QTest::newRow("dash count infinite") << QList<float> { P::CommandSetDashPattern, inf, 1, 1 } << false;
+    QTest::newRow("code nan") << QList<float> { nan } << false;
+    QTest::newRow("code infinite") << QList<float> { inf } << false;
+    QTest::newRow("code negative") << QList<float> { -1 } << false;
+    QTest::newRow("code unknown") << QList<float> { P::CommandSetSimplifyTolerance + 1 } << false;
+    QTest::newRow("cap style") << QList<float> { P::CommandSetCapStyle, Qt::RoundCap } << true;
+    QTest::newRow("cap style invalid") << QList<float> { P::CommandSetCapStyle, 5 } << false;
+    QTest::newRow("join style") << QList<float> { P::CommandSetJoinStyle, Qt::BevelJoin } << true;
+    QTest::newRow("join style invalid") << QList<float> { P::CommandSetJoinStyle, 1e30f } << false;
+    QTest::newRow("composite style") << QList<float> { P::CommandSetCompositeStyle, float(NanoPainter::Composite::Xor) } << true;
+    QTest::newRow("composite style invalid") << QList<float> { P::CommandSetCompositeStyle, float(NanoPainter::Composite::Xor) + 1 } << false;
+}
+
+void tst_NanoShapePainter::execute()
+{
+    QFETCH(QList<float>, commands);
+    QFETCH(bool, result);
+
+    QQuickItem item;
+    item.setSize({ 100, 100 });
+    NanoShapePainter painter(&item);
+    QCOMPARE(painter.execute(toBuffer(commands)), result);
+}
+
+void tst_NanoShapePainter::executeFloat64()
+{
+    QJSEngine engine;
+    QQuickItem item;
+    item.setSize({ 100, 100 });
+    NanoShapePainter painter(&item);
+
+    // the view of part of the buffer is read, not the whole buffer
+    auto commands = engine.evaluate(QStringLiteral("new Float64Array([%1, 2, 0, 0, 10, 10, %2]).subarray(0, 6)")
+            .arg(NanoShapePainter::CommandAddPolygon).arg(NanoShapePainter::CommandFill));
+    QVERIFY(painter.execute(QVariant::fromValue(commands)));
+
+    auto truncated = engine.evaluate(QStringLiteral("new Float64Array([%1, 2, 0, 0, 10, 10]).subarray(0, 5)")
+            .arg(NanoShapePainter::CommandAddPolygon));
+    QVERIFY(!painter.execute(QVariant::fromValue(truncated)));
+
+    auto huge = engine.evaluate(QStringLiteral("new Float64Array([%1, 1e300, 0, 0])").arg(NanoShapePainter::CommandAddPolygon));
+    QVERIFY(!painter.execute(QVariant::fromValue(huge)));
+}
+
+QTEST_MAIN(tst_NanoShapePainter)
+
+#include "tst_nanoshapepainter.moc"
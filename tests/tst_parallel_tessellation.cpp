@@ -0,0 +1,209 @@
+//
+// https://github.com/SteveKChiu/nanoshape
+//
+// Copyright 2024, Steve K. Chiu <steve.k.chiu@gmail.com>
+//
+// The MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+// NanoPainter tessellates the fill and stroke calls on worker contexts from the snapshot of nanovg state
+// and path, this checks the vertices are the same as serial tessellation.
+
+extern "C" {
+#include "nanovg.h"
+}
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+//---------------------------------------------------------------------------
+
+struct Output
+{
+    std::vector<NVGvertex> vertices;
+
+    void add(const NVGvertex* v, int n)
+    {
+        vertices.insert(vertices.end(), v, v + n);
+    }
+};
+
+struct Job
+{
+    NVGsnapshot* snapshot;
+    bool stroke;
+};
+
+static int renderCreate(void*)
+{
+    return 1;
+}
+
+static void renderViewport(void*, float, float, float)
+{
+    // do nothing
+}
+
+static void renderFlush(void*)
+{
+    // do nothing
+}
+
+static void renderFill(void* uptr, NVGpaint*, NVGcompositeOperationState, NVGscissor*, float, const float*, const NVGpath* paths, int npaths)
+{
+    auto out = static_cast<Output*>(uptr);
+    for (int i = 0; i < npaths; ++i) {
+        out->add(paths[i].fill, paths[i].nfill);
+        out->add(paths[i].stroke, paths[i].nstroke);
+    }
+}
+
+static void renderStroke(void* uptr, NVGpaint*, NVGcompositeOperationState, NVGscissor*, float, float, const NVGpath* paths, int npaths)
+{
+    auto out = static_cast<Output*>(uptr);
+    for (int i = 0; i < npaths; ++i) {
+        out->add(paths[i].stroke, paths[i].nstroke);
+    }
+}
+
+static NVGcontext* createContext(Output* out)
+{
+    NVGparams params;
+    memset(&params, 0, sizeof(params));
+    params.userPtr = out;
+    params.edgeAntiAlias = 1;
+    params.renderCreate = &renderCreate;
+    params.renderViewport = &renderViewport;
+    params.renderCancel = &renderFlush;
+    params.renderFlush = &renderFlush;
+    params.renderFill = &renderFill;
+    params.renderStroke = &renderStroke;
+    return nvgCreateInternal(&params);
+}
+
+static void replay(NVGcontext* ctx, const Job& job)
+{
+    nvgInternalRestore(ctx, job.snapshot);
+    if (job.stroke) {
+        nvgStroke(ctx);
+    } else {
+        nvgFill(ctx);
+    }
+}
+
+// the paths cover the fill (convex and concave), the stroke joins, caps, dashes and hairlines
+static std::vector<Job> recordJobs(NVGcontext* ctx, int count)
+{
+    static const int joins[] = { NVG_MITER, NVG_ROUND, NVG_BEVEL };
+    static const int caps[] = { NVG_BUTT, NVG_ROUND, NVG_SQUARE };
+    static float dashes[] = { 6, 3, 1, 3 };
+
+    std::mt19937 random(1);
+    auto coord = [&random] { return float(random() % 1000); };
+
+    std::vector<Job> jobs;
+    for (int i = 0; i < count; ++i) {
+        nvgBeginPath(ctx);
+        nvgResetTransform(ctx);
+        nvgRotate(ctx, float(i % 7) * 0.1f);
+        nvgLineJoin(ctx, joins[i % 3]);
+        nvgLineCap(ctx, caps[(i / 3) % 3]);
+        nvgStrokeWidth(ctx, i % 5 == 0 ? 0.5f : float(1 + i % 9));
+        nvgDashArray(ctx, i % 4 == 0 ? dashes : nullptr, i % 4 == 0 ? 4 : 0);
+
+        if (i % 6 == 0) {
+            nvgRoundedRect(ctx, coord(), coord(), 50, 30, 8);
+        } else {
+            nvgMoveTo(ctx, coord(), coord());
+            for (int j = 0; j < 10; ++j) {
+                nvgBezierTo(ctx, coord(), coord(), coord(), coord(), coord(), coord());
+            }
+            if (i % 2 == 0) nvgClosePath(ctx);
+        }
+
+        jobs.push_back({ nvgInternalSnapshot(ctx), i % 2 == 1 });
+    }
+    return jobs;
+}
+
+//---------------------------------------------------------------------------
+
+int main()
+{
+    static constexpr int JOB_COUNT = 4000;
+    static constexpr int BATCH_SIZE = 64;
+
+    Output serial;
+    auto ctx = createContext(&serial);
+    nvgBeginFrame(ctx, 1000, 1000, 2);
+    auto jobs = recordJobs(ctx, JOB_COUNT);
+
+    for (auto& job : jobs) {
+        replay(ctx, job);
+    }
+
+    // the batches are tessellated on their own context, and merged in the order they are recorded
+    int batchCount = (JOB_COUNT + BATCH_SIZE - 1) / BATCH_SIZE;
+    int threadCount = std::max(2, int(std::thread::hardware_concurrency()));
+    std::vector<Output> batches(batchCount);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            auto worker = createContext(nullptr);
+            for (int b = t; b < batchCount; b += threadCount) {
+                nvgInternalParams(worker)->userPtr = &batches[b];
+                nvgBeginFrame(worker, 1000, 1000, 2);
+                for (int i = b * BATCH_SIZE, n = std::min(JOB_COUNT, i + BATCH_SIZE); i < n; ++i) {
+                    replay(worker, jobs[i]);
+                }
+            }
+            nvgDeleteInternal(worker);
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    Output parallel;
+    for (auto& batch : batches) {
+        parallel.add(batch.vertices.data(), int(batch.vertices.size()));
+    }
+
+    for (auto& job : jobs) {
+        nvgInternalDeleteSnapshot(job.snapshot);
+    }
+    nvgDeleteInternal(ctx);
+
+    auto same = serial.vertices.size() == parallel.vertices.size()
+            && memcmp(serial.vertices.data(), parallel.vertices.data(), serial.vertices.size() * sizeof(NVGvertex)) == 0;
+    if (!same) {
+        printf("FAIL: parallel tessellation is different from serial tessellation\n");
+        return 1;
+    }
+    return 0;
+}